@@ -16,6 +16,7 @@ Created on July 28, 2014
 #include "Filter.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
+#include "FieldParsers.hpp"
 
 namespace lc
 {
@@ -54,13 +55,13 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
         if (raw_data.empty()) {
             return 0;
         }
         else {
-            return boost::lexical_cast<FilterValue>(raw_data.c_str());
+            return string_to_unsigned(raw_data);
         }
     }
 
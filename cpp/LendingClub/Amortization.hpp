@@ -0,0 +1,113 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_AMORTIZATION_HPP__
+#define __LC_AMORTIZATION_HPP__
+
+#include <algorithm>
+#include <cmath>
+
+namespace lc
+{
+
+// What a loan pays a 25 dollar note, see amortize()
+//
+struct AmortizationTerms
+{
+    double                          funded_amnt;
+    double                          int_rate;           // percent a year
+    unsigned                        number_of_payments;
+    double                          installment;
+    double                          total_pymnt;
+    bool                            defaulted;
+    double                          defaulted_amount;   // what the whole loan lost when it defaulted
+};
+
+struct Amortization
+{
+    double                          profit;
+    double                          principal;
+    double                          lost;
+};
+
+// The note's share of the loan month by month: every month the interest on the balance less the 1%
+// service charge is profit, the balance is principal, and the balance goes down by one installment.
+// A defaulted loan stops in the first month its payments so far exceed what it paid in total, and the
+// note loses its share of the defaulted amount.
+//
+// This is the loop normalize_loan_data used to run, kept to check amortize() against.
+//
+inline Amortization amortize_by_month(const AmortizationTerms& terms)
+{
+    Amortization result = Amortization();
+    unsigned elapsed = terms.number_of_payments;
+    double balance = terms.funded_amnt;
+    double ratio = 25.0 / balance;
+    double payments = 0.0;
+    while (elapsed > 0) {
+        --elapsed;
+        double interest = balance * terms.int_rate / 1200.0;
+        double service = 0.01 * terms.installment;
+        payments += terms.installment;
+        if (terms.defaulted && payments > terms.total_pymnt) {
+            result.profit -= terms.defaulted_amount * ratio;
+            result.lost += terms.defaulted_amount * ratio;
+            break;
+        }
+        result.profit += (interest - service) * ratio;
+        result.principal += balance * ratio;
+        balance -= terms.installment;
+    }
+    return result;
+}
+
+// amortize_by_month() in closed form. The balance falls by the same installment every month, so over
+// m whole months the balances add up to m * funded - installment * m * (m - 1) / 2 and the interest is
+// that times the monthly rate. Only the month a defaulted loan stops in is still searched for, with the
+// same running sum of payments so it stops in the same month.
+//
+inline Amortization amortize(const AmortizationTerms& terms)
+{
+    Amortization result = Amortization();
+    unsigned months = terms.number_of_payments;
+
+    if (terms.defaulted) {
+        double payments = 0.0;
+        for (unsigned month = 0; month < terms.number_of_payments; ++month) {
+            payments += terms.installment;
+            if (payments > terms.total_pymnt) {
+                months = month;
+                result.lost = terms.defaulted_amount * (25.0 / terms.funded_amnt);
+                break;
+            }
+        }
+    }
+
+    double ratio = 25.0 / terms.funded_amnt;
+    double m = static_cast<double>(months);
+    double balances = m * terms.funded_amnt - terms.installment * (m * (m - 1.0) * 0.5);
+    result.principal = balances * ratio;
+    result.profit = (balances * terms.int_rate / 1200.0 - 0.01 * terms.installment * m) * ratio - result.lost;
+    return result;
+}
+
+// True when a and b agree to within max_error relative to the larger of them, or absolutely for values
+// under a dollar where the profit of a loan can cancel out to about zero
+//
+inline bool amortization_close(const double a, const double b, const double max_error)
+{
+    return std::fabs(a - b) <= max_error * std::max(1.0, std::max(std::fabs(a), std::fabs(b)));
+}
+
+};
+
+#endif // __LC_AMORTIZATION_HPP__
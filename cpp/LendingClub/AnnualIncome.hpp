@@ -16,6 +16,7 @@ Created on July 28, 2014
 #include "Filter.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
+#include "FieldParsers.hpp"
 
 namespace lc
 {
@@ -54,9 +55,16 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
-        return (raw_data.empty()) ? 0 : boost::numeric_cast<FilterValue>(boost::lexical_cast<double>(raw_data.c_str()));
+        if (raw_data.empty()) {
+            return 0;
+        }
+        double value;
+        if (!parse_decimal(raw_data, value)) {
+            value = boost::lexical_cast<double>(raw_data.data(), raw_data.size());
+        }
+        return boost::numeric_cast<FilterValue>(value);
     }
 
     virtual const LCString get_string_value() const
@@ -0,0 +1,331 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+#include "CpuTopology.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+
+using namespace lc;
+
+namespace
+{
+
+#ifdef __linux__
+
+// First line of a sysfs file, empty when there is none
+//
+LCString read_line(const boost::filesystem::path& path)
+{
+    std::ifstream in(path.string());
+    LCString line;
+    std::getline(in, line);
+    boost::trim(line);
+    return line;
+}
+
+int read_int(const boost::filesystem::path& path, const int missing)
+{
+    int value = missing;
+    LCString line = read_line(path);
+    if (line.empty() || !boost::conversion::try_lexical_convert(line, value)) {
+        return missing;
+    }
+    return value;
+}
+
+// The first cpu sharing the highest level cache of cpu, cpu itself when sysfs has no caches
+//
+int read_last_level_cache(const boost::filesystem::path& cpu_path, const int cpu)
+{
+    int cache = cpu;
+    int highest_level = -1;
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it(cpu_path / "cache", ec), end; !ec && (it != end); it.increment(ec)) {
+        if (!boost::starts_with(it->path().filename().string(), "index")) {
+            continue;
+        }
+
+        int level = read_int(it->path() / "level", -1);
+        std::vector<int> shared;
+        if ((level > highest_level) && CpuTopology::parse_cpu_list(read_line(it->path() / "shared_cpu_list"), shared)) {
+            highest_level = level;
+            cache = *std::min_element(shared.begin(), shared.end());
+        }
+    }
+    return cache;
+}
+
+#endif
+
+// Position of value among the values of its group, in order
+//
+template<typename Key, typename Value>
+unsigned rank_in(const std::map<Key, std::set<Value>>& groups, const Key& key, const Value& value)
+{
+    const auto& values = groups.at(key);
+    return static_cast<unsigned>(std::distance(values.begin(), values.find(value)));
+}
+
+};
+
+CpuTopology::CpuTopology()
+{
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return;
+    }
+
+    std::map<int, int> nodes;
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it("/sys/devices/system/node", ec), end; !ec && (it != end); it.increment(ec)) {
+        LCString name = it->path().filename().string();
+        int node = 0;
+        std::vector<int> node_cpus;
+        if (boost::starts_with(name, "node") && boost::conversion::try_lexical_convert(name.substr(4), node) &&
+            parse_cpu_list(read_line(it->path() / "cpulist"), node_cpus)) {
+            for (auto cpu : node_cpus) {
+                nodes[cpu] = node;
+            }
+        }
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+
+        boost::filesystem::path cpu_path = "/sys/devices/system/cpu/cpu" + boost::lexical_cast<LCString>(cpu);
+        Cpu info;
+        info.cpu = cpu;
+        info.core = read_int(cpu_path / "topology" / "core_id", cpu);
+        info.package = read_int(cpu_path / "topology" / "physical_package_id", 0);
+        info.cache = read_last_level_cache(cpu_path, cpu);
+        info.node = nodes.count(cpu) ? nodes[cpu] : 0;
+        _cpus.push_back(info);
+    }
+#else
+    for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+        Cpu info;
+        info.cpu = static_cast<int>(cpu);
+        info.core = info.cpu;
+        info.cache = info.cpu;
+        info.node = 0;
+        info.package = 0;
+        _cpus.push_back(info);
+    }
+#endif
+}
+
+const CpuTopology& CpuTopology::Get()
+{
+    static CpuTopology topology;
+    return topology;
+}
+
+bool CpuTopology::parse_affinity(const LCString& name, Affinity& affinity)
+{
+    if (name == "none") {
+        affinity = Affinity::NONE;
+    } else if (name == "compact") {
+        affinity = Affinity::COMPACT;
+    } else if (name == "scatter") {
+        affinity = Affinity::SCATTER;
+    } else if (name == "list") {
+        affinity = Affinity::LIST;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+LCString CpuTopology::get_name(const Affinity affinity)
+{
+    switch (affinity) {
+    case Affinity::NONE:    return "none";
+    case Affinity::COMPACT: return "compact";
+    case Affinity::SCATTER: return "scatter";
+    case Affinity::LIST:    return "list";
+    }
+    return "unknown";
+}
+
+bool CpuTopology::parse_cpu_list(const LCString& list, std::vector<int>& cpus)
+{
+    cpus.clear();
+    StringVector items;
+    boost::split(items, list, boost::is_any_of(","));
+
+    for (auto item : items) {
+        boost::trim(item);
+        if (item.empty()) {
+            continue;
+        }
+
+        StringVector bounds;
+        boost::split(bounds, item, boost::is_any_of("-"));
+        int first = 0;
+        int last = 0;
+        if ((bounds.size() > 2) || !boost::conversion::try_lexical_convert(bounds.front(), first) ||
+            !boost::conversion::try_lexical_convert(bounds.back(), last) || (first < 0) || (first > last)) {
+            cpus.clear();
+            return false;
+        }
+
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return !cpus.empty();
+}
+
+bool CpuTopology::pin_current_thread(const int cpu)
+{
+#ifdef __linux__
+    if ((cpu < 0) || (cpu >= CPU_SETSIZE)) {
+        return false;
+    }
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    return (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0);
+#else
+    return false;
+#endif
+}
+
+bool CpuTopology::assign(const Affinity affinity, const std::vector<int>& cpu_list, const unsigned num_threads,
+    std::vector<int>& thread_cpus, LCString& error) const
+{
+    thread_cpus.clear();
+    std::vector<int> order;
+
+    if ((affinity == Affinity::NONE) || _cpus.empty()) {
+        return true;
+    }
+
+    if (affinity == Affinity::LIST) {
+        if (cpu_list.empty()) {
+            error = "no cpus listed";
+            return false;
+        }
+        for (auto cpu : cpu_list) {
+            if (find(cpu) == nullptr) {
+                error = "cpu " + boost::lexical_cast<LCString>(cpu) + " is not available to this process";
+                return false;
+            }
+        }
+        order = cpu_list;
+    } else {
+        // Rank every cpu within its core, cache, node and package, then sort the cpus by the ranks
+        //
+        std::map<std::pair<int, int>, std::set<int>> core_cpus;
+        std::map<int, std::set<std::pair<int, int>>> cache_cores;
+        std::map<std::pair<int, int>, std::set<int>> node_caches;
+        std::map<int, std::set<int>> package_nodes;
+        for (const auto& c : _cpus) {
+            core_cpus[std::make_pair(c.package, c.core)].insert(c.cpu);
+            cache_cores[c.cache].insert(std::make_pair(c.package, c.core));
+            node_caches[std::make_pair(c.package, c.node)].insert(c.cache);
+            package_nodes[c.package].insert(c.node);
+        }
+
+        typedef std::tuple<unsigned, unsigned, unsigned, unsigned, int, int> Key;
+        std::vector<std::pair<Key, int>> keyed;
+        for (const auto& c : _cpus) {
+            unsigned sibling = rank_in(core_cpus, std::make_pair(c.package, c.core), c.cpu);
+            if (affinity == Affinity::COMPACT) {
+                // A hyperthread only once every core has a thread, otherwise in package, node, cache and core order
+                //
+                unsigned node = rank_in(package_nodes, c.package, c.node);
+                unsigned cache = rank_in(node_caches, std::make_pair(c.package, c.node), c.cache);
+                unsigned core = rank_in(cache_cores, c.cache, std::make_pair(c.package, c.core));
+                keyed.push_back(std::make_pair(Key(sibling, static_cast<unsigned>(c.package), node, cache, core, c.cpu), c.cpu));
+            } else {
+                // Round robin over the packages, within them over the nodes and within those over the caches
+                //
+                unsigned core = rank_in(cache_cores, c.cache, std::make_pair(c.package, c.core));
+                unsigned cache = rank_in(node_caches, std::make_pair(c.package, c.node), c.cache);
+                unsigned node = rank_in(package_nodes, c.package, c.node);
+                keyed.push_back(std::make_pair(Key(sibling, core, cache, node, c.package, c.cpu), c.cpu));
+            }
+        }
+
+        std::sort(keyed.begin(), keyed.end());
+        for (const auto& k : keyed) {
+            order.push_back(k.second);
+        }
+    }
+
+    for (unsigned i = 0; i < num_threads; ++i) {
+        thread_cpus.push_back(order[i % order.size()]);
+    }
+    return true;
+}
+
+const CpuTopology::Cpu* CpuTopology::find(const int cpu) const
+{
+    for (const auto& c : _cpus) {
+        if (c.cpu == cpu) {
+            return &c;
+        }
+    }
+    return nullptr;
+}
+
+unsigned CpuTopology::num_nodes() const
+{
+    std::set<int> nodes;
+    for (const auto& c : _cpus) {
+        nodes.insert(c.node);
+    }
+    return static_cast<unsigned>(nodes.size());
+}
+
+unsigned CpuTopology::num_packages() const
+{
+    std::set<int> packages;
+    for (const auto& c : _cpus) {
+        packages.insert(c.package);
+    }
+    return static_cast<unsigned>(packages.size());
+}
+
+LCString CpuTopology::describe(const int cpu) const
+{
+    const Cpu* c = find(cpu);
+    if (c == nullptr) {
+        return "cpu " + boost::lexical_cast<LCString>(cpu);
+    }
+    return boost::str(boost::format("cpu %d (core %d, cache %d, node %d, package %d)") % c->cpu % c->core % c->cache %
+        c->node % c->package);
+}
@@ -0,0 +1,89 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_CPU_TOPOLOGY_HPP__
+#define __LC_CPU_TOPOLOGY_HPP__
+
+#include <cstdint>
+#include <vector>
+#include "Types.hpp"
+
+namespace lc
+{
+
+//
+// The cpus this process may run on and where they sit: physical core, shared last level cache, NUMA
+// node and package, read from /sys/devices/system on Linux. Elsewhere every cpu is its own core on
+// node 0 and threads are never pinned.
+//
+// assign() lays threads out on the cpus for an affinity policy selected by the "affinity" argument:
+//   compact - fill the cores of one cache, node and package before the next
+//   scatter - spread the threads over packages, then nodes, then caches
+//   list    - the cpus given by the "cpu_list" argument, in that order
+// Both compact and scatter give every thread its own physical core and only use the other hyperthreads
+// of a core once every core has a thread. With more threads than cpus the layout wraps around.
+//
+class CpuTopology
+{
+public:
+    enum class Affinity : std::int8_t { NONE = 0, COMPACT = 1, SCATTER = 2, LIST = 3 };
+
+    struct Cpu
+    {
+        int                             cpu;
+        int                             core;           // physical core id, unique within the package
+        int                             cache;          // first cpu sharing the last level cache
+        int                             node;
+        int                             package;
+    };
+
+    // Read once, before any thread of the process is pinned
+    static const CpuTopology& Get();
+
+    static bool parse_affinity(const LCString& name, Affinity& affinity);
+    static LCString get_name(const Affinity affinity);
+
+    // Parses a list like 0,2,8-11
+    static bool parse_cpu_list(const LCString& list, std::vector<int>& cpus);
+
+    // Pins the calling thread to cpu, returns false where that is not supported or the system refused
+    static bool pin_current_thread(const int cpu);
+
+    // The cpu for each of num_threads threads, empty with Affinity::NONE. Returns false and sets error
+    // when cpu_list has a cpu the process may not run on.
+    //
+    bool assign(const Affinity affinity, const std::vector<int>& cpu_list, const unsigned num_threads,
+        std::vector<int>& thread_cpus, LCString& error) const;
+
+    const std::vector<Cpu>& get_cpus() const
+    {
+        return _cpus;
+    }
+
+    // nullptr when the process may not run on cpu
+    const Cpu* find(const int cpu) const;
+
+    unsigned num_nodes() const;
+    unsigned num_packages() const;
+
+    // cpu 5 (core 2, cache 4, node 0, package 0)
+    LCString describe(const int cpu) const;
+
+private:
+    CpuTopology();
+
+    std::vector<Cpu>                            _cpus;          // ordered by cpu number
+};
+
+};
+
+#endif // __LC_CPU_TOPOLOGY_HPP__
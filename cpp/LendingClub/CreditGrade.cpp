@@ -19,5 +19,6 @@ const LCString CreditGrade::csv_name = "grade";
 const LCString CreditGrade::name = "CreditGrade";
 std::map<LCString, FilterValue> CreditGrade::_converation_table;
 std::map<FilterValue, LCString> CreditGrade::_reverse_table;
+PerfectHashMap CreditGrade::_lookup;
 const FilterValueVector* CreditGrade::options = nullptr;
 const Filter::Relation CreditGrade::relation = Filter::Relation::MASK;
\ No newline at end of file
@@ -17,6 +17,7 @@ Created on July 28, 2014
 #include "Arguments.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
+#include "PerfectHashMap.hpp"
 
 namespace lc
 {
@@ -67,6 +68,8 @@ public:
                     }
                 }
             }
+
+            _lookup.build(_converation_table);
         }
 
         if (options == nullptr) {
@@ -96,9 +99,13 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
-        return _converation_table[raw_data];
+        // An unknown grade matches nothing
+        //
+        FilterValue value = 0;
+        _lookup.find(raw_data, value);
+        return value;
     }
 
     virtual const LCString get_string_value() const
@@ -119,6 +126,7 @@ public:
 private:
     static std::map<LCString, FilterValue>   _converation_table;
     static std::map<FilterValue, LCString>   _reverse_table;
+    static PerfectHashMap                    _lookup;
 };
 
 };
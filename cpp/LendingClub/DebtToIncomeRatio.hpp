@@ -16,6 +16,7 @@ Created on July 28, 2014
 #include "Filter.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
+#include "FieldParsers.hpp"
 
 namespace lc
 {
@@ -54,17 +55,14 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
         // Convert DTI 19.48 into normalized 1948
-        LCString data;   
-        if (raw_data[raw_data.length() - 1] == '%') {
-            data = raw_data.substr(0, raw_data.length() - 1);
+        LCStringRef data = raw_data;
+        if (!data.empty() && (data.back() == '%')) {
+            data.remove_suffix(1);
         }
-        else {
-            data = raw_data;
-        }
-        return boost::numeric_cast<FilterValue>(strtod(data.c_str(), nullptr) * 100);
+        return boost::numeric_cast<FilterValue>(string_to_double(data) * 100);
     }
 
     virtual const LCString get_string_value() const
@@ -16,6 +16,7 @@ Created on July 28, 2014
 #include "Filter.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
+#include "FieldParsers.hpp"
 
 namespace lc
 {
@@ -60,9 +61,9 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
-        auto result = (raw_data.empty()) ? 0 : boost::lexical_cast<FilterValue>(raw_data.c_str());
+        auto result = (raw_data.empty()) ? 0 : string_to_unsigned(raw_data);
         return (result <= 11) ? (1 << result) : (1 << 11);
     }
 
@@ -18,6 +18,7 @@ Created on July 28, 2014
 #include "Filter.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
+#include "FieldParsers.hpp"
 
 namespace lc
 {
@@ -65,13 +66,13 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
         if (raw_data.empty()) {
             return 0;
         }
         else {
-            boost::posix_time::ptime raw_time(boost::gregorian::from_simple_string(raw_data));
+            boost::posix_time::ptime raw_time(string_to_date(raw_data));
             return (now - raw_time).total_seconds();
         }
     }
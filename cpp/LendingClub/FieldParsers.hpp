@@ -0,0 +1,155 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_FIELD_PARSERS_HPP__
+#define __LC_FIELD_PARSERS_HPP__
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include "Types.hpp"
+
+namespace lc
+{
+
+//
+// Parsers for the CSV fields the converters and LoanData read. They work on the field in place, the
+// common forms are parsed by hand and anything else goes to the library parser the field was read
+// with before, so every field converts to exactly the same value.
+//
+
+// Parses a plain decimal like 19.48 or 98109 the way strtod does, returns false for anything else
+// (signs, exponents, blanks, more than 15 digits). The digits and the power of ten are both exact
+// doubles, so the one division rounds the same as strtod.
+//
+inline bool parse_decimal(const LCStringRef& data, double& value)
+{
+    static const double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15 };
+
+    std::uint64_t mantissa = 0;
+    unsigned num_digits = 0;
+    unsigned num_fraction_digits = 0;
+    bool fraction = false;
+
+    for (char c : data) {
+        if ((c >= '0') && (c <= '9')) {
+            mantissa = mantissa * 10 + (c - '0');
+            ++num_digits;
+            num_fraction_digits += fraction;
+        } else if ((c == '.') && !fraction) {
+            fraction = true;
+        } else {
+            return false;
+        }
+    }
+
+    if ((num_digits == 0) || (num_digits > 15)) {
+        return false;
+    }
+    value = static_cast<double>(mantissa) / powers_of_ten[num_fraction_digits];
+    return true;
+}
+
+// strtod of a field, which is not null terminated
+inline double string_to_double(const LCStringRef& data)
+{
+    double value;
+    if (parse_decimal(data, value)) {
+        return value;
+    }
+
+    char buffer[64];
+    size_t length = std::min(data.size(), sizeof(buffer) - 1);
+    std::memcpy(buffer, data.data(), length);
+    buffer[length] = '\0';
+    return strtod(buffer, nullptr);
+}
+
+// boost::lexical_cast<FilterValue> of a field, throws boost::bad_lexical_cast the same way
+inline FilterValue string_to_unsigned(const LCStringRef& data)
+{
+    if ((data.size() == 0) || (data.size() > 19)) {
+        return boost::lexical_cast<FilterValue>(data.data(), data.size());
+    }
+
+    FilterValue value = 0;
+    for (char c : data) {
+        if ((c < '0') || (c > '9')) {
+            return boost::lexical_cast<FilterValue>(data.data(), data.size());
+        }
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+inline bool is_digits(const char* p, const unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i) {
+        if ((p[i] < '0') || (p[i] > '9')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline unsigned digits_to_unsigned(const char* p, const unsigned count)
+{
+    unsigned value = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        value = value * 10 + (p[i] - '0');
+    }
+    return value;
+}
+
+// Returns 1 to 12 for Jan to Dec, 0 for anything else
+inline unsigned month_from_name(const char* p)
+{
+    static const char names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    for (unsigned month = 0; month < 12; ++month) {
+        if (std::memcmp(p, names + 3 * month, 3) == 0) {
+            return month + 1;
+        }
+    }
+    return 0;
+}
+
+// boost::gregorian::from_simple_string of a field. The forms in the stats files, 2007-Aug-01 and
+// 2007-08-01, are parsed here, an invalid date still throws from the boost::gregorian::date constructor.
+//
+inline boost::gregorian::date string_to_date(const LCStringRef& data)
+{
+    const char* p = data.data();
+    unsigned month = 0;
+    unsigned day = 0;
+
+    if ((data.size() == 11) && is_digits(p, 4) && (p[4] == '-') && (p[8] == '-') && is_digits(p + 9, 2)) {
+        month = month_from_name(p + 5);
+        day = digits_to_unsigned(p + 9, 2);
+    } else if ((data.size() == 10) && is_digits(p, 4) && (p[4] == '-') && is_digits(p + 5, 2) && (p[7] == '-') && is_digits(p + 8, 2)) {
+        month = digits_to_unsigned(p + 5, 2);
+        day = digits_to_unsigned(p + 8, 2);
+    }
+
+    if ((month == 0) || (month > 12)) {
+        return boost::gregorian::from_simple_string(data.to_string());
+    }
+    return boost::gregorian::date(static_cast<unsigned short>(digits_to_unsigned(p, 4)), static_cast<unsigned short>(month),
+        static_cast<unsigned short>(day));
+}
+
+};
+
+#endif // __LC_FIELD_PARSERS_HPP__
@@ -46,9 +46,24 @@ public:
     virtual const FilterValueVector& get_options() = 0;
     virtual void set_options(const FilterValueVector* new_options) = 0;
     virtual bool apply(const Loan& loan) const = 0;
-    virtual FilterValue convert(const LCString& raw_data) const = 0;
+    virtual FilterValue convert(const LCStringRef& raw_data) const = 0;
     virtual Relation get_relation() = 0;
 
+    // Evaluates a single relation, this is what each filter's apply() does for its own relation
+    static inline bool compare(const Relation relation, const LoanValue loan_value, const FilterValue filter_value)
+    {
+        switch (relation) {
+        case Relation::LESS_THAN_EQUAL:    return (loan_value <= filter_value);
+        case Relation::LESS_THAN:          return (loan_value <  filter_value);
+        case Relation::GREATER_THAN:       return (loan_value >  filter_value);
+        case Relation::GREATER_THAN_EQUAL: return (loan_value >= filter_value);
+        case Relation::MASK:               return ((loan_value & filter_value) > 0);
+        case Relation::EQUAL:              return (loan_value == filter_value);
+        case Relation::NOT_EQUAL:          return (loan_value != filter_value);
+        }
+        return false;
+    }
+
     inline const FilterValue get_value() const
     {
         return _value;
@@ -66,6 +81,13 @@ public:
         _value = get_options()[_current];
     }
 
+    // Sets an option whose value was already looked up, as Genome::load does, without going through get_options()
+    inline void set_current(const unsigned current, const FilterValue value)
+    {
+        _current = current;
+        _value = value;
+    }
+
     virtual const LCString get_string_value() const = 0;
 
     size_t get_count()
@@ -0,0 +1,469 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#include "FilterKernels.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LC_X86_KERNELS 1
+#include <immintrin.h>
+#define LC_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define LC_TARGET_AVX2 __attribute__((target("avx2")))
+#define LC_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#else
+#define LC_X86_KERNELS 0
+#endif
+
+using namespace lc;
+
+namespace
+{
+
+// Every relation is one of these predicates, possibly inverted
+//
+enum Predicate { LE = 0, GE = 1, EQ = 2, MASK_ZERO = 3 };
+
+void to_predicate(const Filter::Relation relation, Predicate& predicate, bool& invert)
+{
+    invert = false;
+    switch (relation) {
+    case Filter::Relation::LESS_THAN_EQUAL:    predicate = LE; break;
+    case Filter::Relation::LESS_THAN:          predicate = GE; invert = true; break;
+    case Filter::Relation::GREATER_THAN:       predicate = LE; invert = true; break;
+    case Filter::Relation::GREATER_THAN_EQUAL: predicate = GE; break;
+    case Filter::Relation::MASK:               predicate = MASK_ZERO; invert = true; break;
+    case Filter::Relation::EQUAL:              predicate = EQ; break;
+    case Filter::Relation::NOT_EQUAL:          predicate = EQ; invert = true; break;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Scalar
+//////////////////////////////////////////////////////////////////////////
+
+template<int P, typename T>
+inline bool scalar_predicate(const T a, const T v)
+{
+    switch (P) {
+    case LE: return a <= v;
+    case GE: return a >= v;
+    case EQ: return a == v;
+    default: return (a & v) == 0;
+    }
+}
+
+template<int P, typename T>
+std::uint64_t scalar_kernel(const T* column, const unsigned num_words, const T value, const std::uint64_t flip, std::uint64_t* mask)
+{
+    std::uint64_t any = 0;
+    for (unsigned w = 0; w < num_words; ++w, column += FilterKernels::rows_per_word) {
+        std::uint64_t bits = 0;
+        for (unsigned i = 0; i < FilterKernels::rows_per_word; ++i) {
+            bits |= static_cast<std::uint64_t>(scalar_predicate<P>(column[i], value)) << i;
+        }
+        mask[w] &= bits ^ flip;
+        any |= mask[w];
+    }
+    return any;
+}
+
+#if LC_X86_KERNELS
+
+//////////////////////////////////////////////////////////////////////////
+// SSE4.2, 128 bit lanes, unsigned compares through min/max, 64 bit through a sign flip
+//////////////////////////////////////////////////////////////////////////
+
+LC_TARGET_SSE42 inline __m128i sse_set1(const std::uint8_t v)  { return _mm_set1_epi8(static_cast<char>(v)); }
+LC_TARGET_SSE42 inline __m128i sse_set1(const std::uint16_t v) { return _mm_set1_epi16(static_cast<short>(v)); }
+LC_TARGET_SSE42 inline __m128i sse_set1(const std::uint32_t v) { return _mm_set1_epi32(static_cast<int>(v)); }
+LC_TARGET_SSE42 inline __m128i sse_set1(const std::uint64_t v) { return _mm_set1_epi64x(static_cast<long long>(v)); }
+
+template<int P> LC_TARGET_SSE42 inline __m128i sse_predicate(const __m128i a, const __m128i v, const std::uint8_t*)
+{
+    switch (P) {
+    case LE: return _mm_cmpeq_epi8(_mm_min_epu8(a, v), a);
+    case GE: return _mm_cmpeq_epi8(_mm_max_epu8(a, v), a);
+    case EQ: return _mm_cmpeq_epi8(a, v);
+    default: return _mm_cmpeq_epi8(_mm_and_si128(a, v), _mm_setzero_si128());
+    }
+}
+
+template<int P> LC_TARGET_SSE42 inline __m128i sse_predicate(const __m128i a, const __m128i v, const std::uint16_t*)
+{
+    switch (P) {
+    case LE: return _mm_cmpeq_epi16(_mm_min_epu16(a, v), a);
+    case GE: return _mm_cmpeq_epi16(_mm_max_epu16(a, v), a);
+    case EQ: return _mm_cmpeq_epi16(a, v);
+    default: return _mm_cmpeq_epi16(_mm_and_si128(a, v), _mm_setzero_si128());
+    }
+}
+
+template<int P> LC_TARGET_SSE42 inline __m128i sse_predicate(const __m128i a, const __m128i v, const std::uint32_t*)
+{
+    switch (P) {
+    case LE: return _mm_cmpeq_epi32(_mm_min_epu32(a, v), a);
+    case GE: return _mm_cmpeq_epi32(_mm_max_epu32(a, v), a);
+    case EQ: return _mm_cmpeq_epi32(a, v);
+    default: return _mm_cmpeq_epi32(_mm_and_si128(a, v), _mm_setzero_si128());
+    }
+}
+
+template<int P> LC_TARGET_SSE42 inline __m128i sse_predicate(const __m128i a, const __m128i v, const std::uint64_t*)
+{
+    const __m128i sign = _mm_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+    const __m128i ones = _mm_set1_epi64x(-1);
+    switch (P) {
+    case LE: return _mm_xor_si128(_mm_cmpgt_epi64(_mm_xor_si128(a, sign), _mm_xor_si128(v, sign)), ones);
+    case GE: return _mm_xor_si128(_mm_cmpgt_epi64(_mm_xor_si128(v, sign), _mm_xor_si128(a, sign)), ones);
+    case EQ: return _mm_cmpeq_epi64(a, v);
+    default: return _mm_cmpeq_epi64(_mm_and_si128(a, v), _mm_setzero_si128());
+    }
+}
+
+template<int P> LC_TARGET_SSE42 inline std::uint64_t sse_word(const std::uint8_t* p, const __m128i v)
+{
+    std::uint64_t bits = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        bits |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(sse_predicate<P>(a, v, p)))) << (16 * i);
+    }
+    return bits;
+}
+
+template<int P> LC_TARGET_SSE42 inline std::uint64_t sse_word(const std::uint16_t* p, const __m128i v)
+{
+    std::uint64_t bits = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i + 8));
+        __m128i packed = _mm_packs_epi16(sse_predicate<P>(a0, v, p), sse_predicate<P>(a1, v, p));
+        bits |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(packed))) << (16 * i);
+    }
+    return bits;
+}
+
+template<int P> LC_TARGET_SSE42 inline std::uint64_t sse_word(const std::uint32_t* p, const __m128i v)
+{
+    std::uint64_t bits = 0;
+    for (unsigned i = 0; i < 16; ++i) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4 * i));
+        bits |= static_cast<std::uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(sse_predicate<P>(a, v, p)))) << (4 * i);
+    }
+    return bits;
+}
+
+template<int P> LC_TARGET_SSE42 inline std::uint64_t sse_word(const std::uint64_t* p, const __m128i v)
+{
+    std::uint64_t bits = 0;
+    for (unsigned i = 0; i < 32; ++i) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * i));
+        bits |= static_cast<std::uint64_t>(_mm_movemask_pd(_mm_castsi128_pd(sse_predicate<P>(a, v, p)))) << (2 * i);
+    }
+    return bits;
+}
+
+template<int P, typename T>
+LC_TARGET_SSE42 std::uint64_t sse_kernel(const T* column, const unsigned num_words, const T value, const std::uint64_t flip, std::uint64_t* mask)
+{
+    const __m128i v = sse_set1(value);
+    std::uint64_t any = 0;
+    for (unsigned w = 0; w < num_words; ++w, column += FilterKernels::rows_per_word) {
+        mask[w] &= sse_word<P>(column, v) ^ flip;
+        any |= mask[w];
+    }
+    return any;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// AVX2, same as SSE4.2 on 256 bit lanes
+//////////////////////////////////////////////////////////////////////////
+
+LC_TARGET_AVX2 inline __m256i avx2_set1(const std::uint8_t v)  { return _mm256_set1_epi8(static_cast<char>(v)); }
+LC_TARGET_AVX2 inline __m256i avx2_set1(const std::uint16_t v) { return _mm256_set1_epi16(static_cast<short>(v)); }
+LC_TARGET_AVX2 inline __m256i avx2_set1(const std::uint32_t v) { return _mm256_set1_epi32(static_cast<int>(v)); }
+LC_TARGET_AVX2 inline __m256i avx2_set1(const std::uint64_t v) { return _mm256_set1_epi64x(static_cast<long long>(v)); }
+
+template<int P> LC_TARGET_AVX2 inline __m256i avx2_predicate(const __m256i a, const __m256i v, const std::uint8_t*)
+{
+    switch (P) {
+    case LE: return _mm256_cmpeq_epi8(_mm256_min_epu8(a, v), a);
+    case GE: return _mm256_cmpeq_epi8(_mm256_max_epu8(a, v), a);
+    case EQ: return _mm256_cmpeq_epi8(a, v);
+    default: return _mm256_cmpeq_epi8(_mm256_and_si256(a, v), _mm256_setzero_si256());
+    }
+}
+
+template<int P> LC_TARGET_AVX2 inline __m256i avx2_predicate(const __m256i a, const __m256i v, const std::uint16_t*)
+{
+    switch (P) {
+    case LE: return _mm256_cmpeq_epi16(_mm256_min_epu16(a, v), a);
+    case GE: return _mm256_cmpeq_epi16(_mm256_max_epu16(a, v), a);
+    case EQ: return _mm256_cmpeq_epi16(a, v);
+    default: return _mm256_cmpeq_epi16(_mm256_and_si256(a, v), _mm256_setzero_si256());
+    }
+}
+
+template<int P> LC_TARGET_AVX2 inline __m256i avx2_predicate(const __m256i a, const __m256i v, const std::uint32_t*)
+{
+    switch (P) {
+    case LE: return _mm256_cmpeq_epi32(_mm256_min_epu32(a, v), a);
+    case GE: return _mm256_cmpeq_epi32(_mm256_max_epu32(a, v), a);
+    case EQ: return _mm256_cmpeq_epi32(a, v);
+    default: return _mm256_cmpeq_epi32(_mm256_and_si256(a, v), _mm256_setzero_si256());
+    }
+}
+
+template<int P> LC_TARGET_AVX2 inline __m256i avx2_predicate(const __m256i a, const __m256i v, const std::uint64_t*)
+{
+    const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    switch (P) {
+    case LE: return _mm256_xor_si256(_mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(v, sign)), ones);
+    case GE: return _mm256_xor_si256(_mm256_cmpgt_epi64(_mm256_xor_si256(v, sign), _mm256_xor_si256(a, sign)), ones);
+    case EQ: return _mm256_cmpeq_epi64(a, v);
+    default: return _mm256_cmpeq_epi64(_mm256_and_si256(a, v), _mm256_setzero_si256());
+    }
+}
+
+template<int P> LC_TARGET_AVX2 inline std::uint64_t avx2_word(const std::uint8_t* p, const __m256i v)
+{
+    std::uint64_t bits = 0;
+    for (unsigned i = 0; i < 2; ++i) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+        bits |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(avx2_predicate<P>(a, v, p)))) << (32 * i);
+    }
+    return bits;
+}
+
+template<int P> LC_TARGET_AVX2 inline std::uint64_t avx2_word(const std::uint16_t* p, const __m256i v)
+{
+    std::uint64_t bits = 0;
+    for (unsigned i = 0; i < 2; ++i) {
+        __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i));
+        __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * i + 16));
+        // packs works within 128 bit lanes, put the lanes back in order before taking the mask
+        __m256i packed = _mm256_packs_epi16(avx2_predicate<P>(a0, v, p), avx2_predicate<P>(a1, v, p));
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+        bits |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm256_movemask_epi8(packed))) << (32 * i);
+    }
+    return bits;
+}
+
+template<int P> LC_TARGET_AVX2 inline std::uint64_t avx2_word(const std::uint32_t* p, const __m256i v)
+{
+    std::uint64_t bits = 0;
+    for (unsigned i = 0; i < 8; ++i) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8 * i));
+        bits |= static_cast<std::uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(avx2_predicate<P>(a, v, p)))) << (8 * i);
+    }
+    return bits;
+}
+
+template<int P> LC_TARGET_AVX2 inline std::uint64_t avx2_word(const std::uint64_t* p, const __m256i v)
+{
+    std::uint64_t bits = 0;
+    for (unsigned i = 0; i < 16; ++i) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 4 * i));
+        bits |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(avx2_predicate<P>(a, v, p)))) << (4 * i);
+    }
+    return bits;
+}
+
+template<int P, typename T>
+LC_TARGET_AVX2 std::uint64_t avx2_kernel(const T* column, const unsigned num_words, const T value, const std::uint64_t flip, std::uint64_t* mask)
+{
+    const __m256i v = avx2_set1(value);
+    std::uint64_t any = 0;
+    for (unsigned w = 0; w < num_words; ++w, column += FilterKernels::rows_per_word) {
+        mask[w] &= avx2_word<P>(column, v) ^ flip;
+        any |= mask[w];
+    }
+    return any;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// AVX-512, unsigned compares straight into mask registers
+//////////////////////////////////////////////////////////////////////////
+
+LC_TARGET_AVX512 inline __m512i avx512_set1(const std::uint8_t v)  { return _mm512_set1_epi8(static_cast<char>(v)); }
+LC_TARGET_AVX512 inline __m512i avx512_set1(const std::uint16_t v) { return _mm512_set1_epi16(static_cast<short>(v)); }
+LC_TARGET_AVX512 inline __m512i avx512_set1(const std::uint32_t v) { return _mm512_set1_epi32(static_cast<int>(v)); }
+LC_TARGET_AVX512 inline __m512i avx512_set1(const std::uint64_t v) { return _mm512_set1_epi64(static_cast<long long>(v)); }
+
+template<int P> LC_TARGET_AVX512 inline std::uint64_t avx512_predicate(const __m512i a, const __m512i v, const std::uint8_t*)
+{
+    switch (P) {
+    case LE: return _mm512_cmp_epu8_mask(a, v, _MM_CMPINT_LE);
+    case GE: return _mm512_cmp_epu8_mask(a, v, _MM_CMPINT_NLT);
+    case EQ: return _mm512_cmp_epu8_mask(a, v, _MM_CMPINT_EQ);
+    default: return _mm512_testn_epi8_mask(a, v);
+    }
+}
+
+template<int P> LC_TARGET_AVX512 inline std::uint64_t avx512_predicate(const __m512i a, const __m512i v, const std::uint16_t*)
+{
+    switch (P) {
+    case LE: return _mm512_cmp_epu16_mask(a, v, _MM_CMPINT_LE);
+    case GE: return _mm512_cmp_epu16_mask(a, v, _MM_CMPINT_NLT);
+    case EQ: return _mm512_cmp_epu16_mask(a, v, _MM_CMPINT_EQ);
+    default: return _mm512_testn_epi16_mask(a, v);
+    }
+}
+
+template<int P> LC_TARGET_AVX512 inline std::uint64_t avx512_predicate(const __m512i a, const __m512i v, const std::uint32_t*)
+{
+    switch (P) {
+    case LE: return _mm512_cmp_epu32_mask(a, v, _MM_CMPINT_LE);
+    case GE: return _mm512_cmp_epu32_mask(a, v, _MM_CMPINT_NLT);
+    case EQ: return _mm512_cmp_epu32_mask(a, v, _MM_CMPINT_EQ);
+    default: return _mm512_testn_epi32_mask(a, v);
+    }
+}
+
+template<int P> LC_TARGET_AVX512 inline std::uint64_t avx512_predicate(const __m512i a, const __m512i v, const std::uint64_t*)
+{
+    switch (P) {
+    case LE: return _mm512_cmp_epu64_mask(a, v, _MM_CMPINT_LE);
+    case GE: return _mm512_cmp_epu64_mask(a, v, _MM_CMPINT_NLT);
+    case EQ: return _mm512_cmp_epu64_mask(a, v, _MM_CMPINT_EQ);
+    default: return _mm512_testn_epi64_mask(a, v);
+    }
+}
+
+template<int P, typename T>
+LC_TARGET_AVX512 std::uint64_t avx512_kernel(const T* column, const unsigned num_words, const T value, const std::uint64_t flip, std::uint64_t* mask)
+{
+    const unsigned lanes = 64 / sizeof(T);
+    const __m512i v = avx512_set1(value);
+    std::uint64_t any = 0;
+    for (unsigned w = 0; w < num_words; ++w, column += FilterKernels::rows_per_word) {
+        std::uint64_t bits = 0;
+        for (unsigned i = 0; i < FilterKernels::rows_per_word / lanes; ++i) {
+            __m512i a = _mm512_loadu_si512(column + lanes * i);
+            bits |= avx512_predicate<P>(a, v, column) << (lanes * i);
+        }
+        mask[w] &= bits ^ flip;
+        any |= mask[w];
+    }
+    return any;
+}
+
+#endif // LC_X86_KERNELS
+
+template<int P, typename T>
+std::uint64_t run_kernel(const FilterKernels::Isa isa, const T* column, const unsigned num_words, const T value,
+    const std::uint64_t flip, std::uint64_t* mask)
+{
+    switch (isa) {
+#if LC_X86_KERNELS
+    case FilterKernels::Isa::AVX512: return avx512_kernel<P>(column, num_words, value, flip, mask);
+    case FilterKernels::Isa::AVX2:   return avx2_kernel<P>(column, num_words, value, flip, mask);
+    case FilterKernels::Isa::SSE42:  return sse_kernel<P>(column, num_words, value, flip, mask);
+#endif
+    default:                         return scalar_kernel<P>(column, num_words, value, flip, mask);
+    }
+}
+
+template<typename T>
+std::uint64_t and_column_matches(const FilterKernels::Isa isa, const Filter::Relation relation, const T* column,
+    const unsigned num_words, FilterValue value, std::uint64_t* mask)
+{
+    std::uint64_t any = 0;
+    switch (ColumnScan::narrow<T>(relation, value)) {
+    case ColumnScan::Narrowed::ALL:
+        for (unsigned w = 0; w < num_words; ++w) {
+            any |= mask[w];
+        }
+        return any;
+    case ColumnScan::Narrowed::NONE:
+        std::fill(mask, mask + num_words, std::uint64_t(0));
+        return 0;
+    case ColumnScan::Narrowed::COMPARE:
+        break;
+    }
+
+    Predicate predicate = LE;
+    bool invert = false;
+    to_predicate(relation, predicate, invert);
+    const std::uint64_t flip = invert ? ~std::uint64_t(0) : 0;
+    const T v = static_cast<T>(value);
+
+    switch (predicate) {
+    case LE: return run_kernel<LE>(isa, column, num_words, v, flip, mask);
+    case GE: return run_kernel<GE>(isa, column, num_words, v, flip, mask);
+    case EQ: return run_kernel<EQ>(isa, column, num_words, v, flip, mask);
+    case MASK_ZERO: return run_kernel<MASK_ZERO>(isa, column, num_words, v, flip, mask);
+    }
+    return any;
+}
+
+};
+
+FilterKernels::Isa FilterKernels::detect()
+{
+#if LC_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return Isa::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return Isa::SSE42;
+    }
+#endif
+    return Isa::SCALAR;
+}
+
+bool FilterKernels::parse_isa(const LCString& name, Isa& isa)
+{
+    if (name == "auto") {
+        isa = detect();
+    } else if (name == "scalar") {
+        isa = Isa::SCALAR;
+    } else if (name == "sse42") {
+        isa = Isa::SSE42;
+    } else if (name == "avx2") {
+        isa = Isa::AVX2;
+    } else if (name == "avx512") {
+        isa = Isa::AVX512;
+    } else {
+        return false;
+    }
+    // Never use more than the cpu supports
+    isa = std::min(isa, detect());
+    return true;
+}
+
+LCString FilterKernels::get_name(const Isa isa)
+{
+    switch (isa) {
+    case Isa::SCALAR: return "scalar";
+    case Isa::SSE42:  return "sse42";
+    case Isa::AVX2:   return "avx2";
+    case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+std::uint64_t FilterKernels::and_matches(const Isa isa, const Filter::Relation relation, const LoanColumn& column,
+    const unsigned first_word, const unsigned num_words, const FilterValue value, std::uint64_t* mask)
+{
+    const unsigned first_row = first_word * rows_per_word;
+    switch (column.width()) {
+    case LoanColumn::Width::U8:  return and_column_matches(isa, relation, column.data<std::uint8_t>() + first_row, num_words, value, mask);
+    case LoanColumn::Width::U16: return and_column_matches(isa, relation, column.data<std::uint16_t>() + first_row, num_words, value, mask);
+    case LoanColumn::Width::U32: return and_column_matches(isa, relation, column.data<std::uint32_t>() + first_row, num_words, value, mask);
+    case LoanColumn::Width::U64: return and_column_matches(isa, relation, column.data<std::uint64_t>() + first_row, num_words, value, mask);
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_FILTER_KERNELS_HPP__
+#define __LC_FILTER_KERNELS_HPP__
+
+#include <cstdint>
+#include "Types.hpp"
+#include "Filter.hpp"
+#include "LoanColumns.hpp"
+
+namespace lc
+{
+
+//
+// Vectorized filter kernels. Each call evaluates one relation over 64 loans per mask word and ANDs
+// the result into the match mask. The instruction set is picked at runtime, the scalar version is
+// used when nothing better is available or on compilers we have no intrinsics support for.
+//
+class FilterKernels
+{
+public:
+    enum class Isa : std::int8_t { SCALAR = 0, SSE42 = 1, AVX2 = 2, AVX512 = 3 };
+
+    // Number of loans covered by one mask word, columns are padded to a multiple of this
+    static const unsigned rows_per_word = 64;
+
+    // Best instruction set supported by this cpu
+    static Isa detect();
+
+    static bool parse_isa(const LCString& name, Isa& isa);
+    static LCString get_name(const Isa isa);
+
+    // ANDs the matches of column <relation> value for the rows [first_word * 64, (first_word + num_words) * 64)
+    // into mask, returns the OR of all the resulting mask words so callers can stop once nothing matches
+    //
+    static std::uint64_t and_matches(const Isa isa, const Filter::Relation relation, const LoanColumn& column,
+        const unsigned first_word, const unsigned num_words, const FilterValue value, std::uint64_t* mask);
+};
+
+};
+
+#endif // __LC_FILTER_KERNELS_HPP__
@@ -0,0 +1,103 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_FILTER_PIPELINE_HPP__
+#define __LC_FILTER_PIPELINE_HPP__
+
+#include "Types.hpp"
+#include "Loan.hpp"
+#include "Filters.hpp"
+
+namespace lc
+{
+
+// One stage of a pipeline, the concrete filter class and the loan value it is converting
+//
+template<Loan::LoanType Type, typename FilterType>
+struct PipelineStage
+{
+    static const Loan::LoanType type = Type;
+    typedef FilterType filter_type;
+};
+
+//
+// Predicate chain over a fixed list of filters known at compile time. Every stage calls the concrete
+// filter's apply() directly, so there is no virtual call nor switch on the relation and the compiler
+// can inline the whole chain. The stages still short circuit, evaluating all 18 with & benchmarked
+// slower since most random filter sets reject a loan within the first few stages.
+//
+template<typename... Stages>
+struct FilterPipeline;
+
+template<>
+struct FilterPipeline<>
+{
+    static const unsigned size = 0;
+
+    static inline bool apply(Filter* const*, const Loan&)
+    {
+        return true;
+    }
+
+    static bool matches(const LoanTypeVector& conversion_filters, const unsigned idx = 0)
+    {
+        return idx == conversion_filters.size();
+    }
+};
+
+template<typename Stage, typename... Stages>
+struct FilterPipeline<Stage, Stages...>
+{
+    typedef typename Stage::filter_type filter_type;
+    typedef FilterPipeline<Stages...> next_type;
+
+    static const unsigned size = next_type::size + 1;
+
+    static inline bool apply(Filter* const* filters, const Loan& loan)
+    {
+        return static_cast<const filter_type*>(*filters)->filter_type::apply(loan) && next_type::apply(filters + 1, loan);
+    }
+
+    // True when the filters built from conversion_filters are exactly the stages of this pipeline
+    static bool matches(const LoanTypeVector& conversion_filters, const unsigned idx = 0)
+    {
+        return (idx < conversion_filters.size()) && (conversion_filters[idx] == Stage::type) &&
+            next_type::matches(conversion_filters, idx + 1);
+    }
+};
+
+// The 18 filter configuration built by lcmain
+//
+typedef FilterPipeline<
+    PipelineStage<Loan::ACC_OPEN_PAST_24MTHS, AccountsOpenPast24Months>,
+    PipelineStage<Loan::FUNDED_AMNT, AmountRequested>,
+    PipelineStage<Loan::ANNUAL_INCOME, AnnualIncome>,
+    PipelineStage<Loan::GRADE, CreditGrade>,
+    PipelineStage<Loan::DEBT_TO_INCOME_RATIO, DebtToIncomeRatio>,
+    PipelineStage<Loan::DELINQ_2YRS, Delinquencies>,
+    PipelineStage<Loan::EARLIEST_CREDIT_LINE, EarliestCreditLine>,
+    PipelineStage<Loan::EMP_LENGTH, EmploymentLength>,
+    PipelineStage<Loan::HOME_OWNERSHIP, HomeOwnership>,
+    PipelineStage<Loan::INCOME_VALIDATED, IncomeValidated>,
+    PipelineStage<Loan::INQ_LAST_6MTHS, InqueriesLast6Months>,
+    PipelineStage<Loan::PURPOSE, LoanPurpose>,
+    PipelineStage<Loan::MTHS_SINCE_LAST_DELINQ, MonthsSinceLastDelinquency>,
+    PipelineStage<Loan::PUB_REC, PublicRecordsOnFile>,
+    PipelineStage<Loan::REVOL_UTILIZATION, RevolvingLineUtilization>,
+    PipelineStage<Loan::ADDR_STATE, State>,
+    PipelineStage<Loan::TOTAL_ACC, TotalCreditLines>,
+    PipelineStage<Loan::DESC_WORD_COUNT, WordsInDescription>
+> StandardFilterPipeline;
+
+};
+
+#endif // __LC_FILTER_PIPELINE_HPP__
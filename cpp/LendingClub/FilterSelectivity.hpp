@@ -0,0 +1,158 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_FILTER_SELECTIVITY_HPP__
+#define __LC_FILTER_SELECTIVITY_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include "Types.hpp"
+#include "Loan.hpp"
+#include "Filter.hpp"
+#include "Genome.hpp"
+#include "LoanColumns.hpp"
+
+namespace lc
+{
+
+//
+// Tracks how many loans each filter lets through and keeps the order filters should be evaluated in,
+// most selective and cheapest first.
+//
+// Every few tests the filters are evaluated independently over a small sample of loans, so the pass
+// rate of a filter does not depend on the filters evaluated before it. Each sample is the next window
+// of the range, so over the iterations the samples cover all of it rather than only the oldest loans at
+// its start. The counts are halved every time the order is adapted so it follows the population as
+// it converges.
+//
+class FilterSelectivity
+{
+public:
+    // One in this many tests is sampled
+    static const unsigned sample_rate = 8;
+
+    // Number of loans each sample looks at
+    static const unsigned sample_size = 2048;
+
+    FilterSelectivity() : _num_tests(0), _sample_offset(0) {}
+
+    // With cost_by_width a filter costs the bytes of its column per loan, which is what the columnar and
+    // simd scans read. The bitmap scan reads one word per filter whatever the column width and the row
+    // scans compare values already loaded with the loan, so for them every filter costs the same and
+    // the order only follows the pass rates.
+    //
+    void initialize(const LoanTypeVector& conversion_filters, const LoanColumns& columns, const bool cost_by_width)
+    {
+        const size_t num_filters = conversion_filters.size();
+        _evaluated.assign(num_filters, 0);
+        _passed.assign(num_filters, 0);
+        _cost.resize(num_filters);
+        _order.resize(num_filters);
+        std::iota(_order.begin(), _order.end(), 0);
+
+        for (size_t k = 0; k < num_filters; ++k) {
+            _cost[k] = cost_by_width ? static_cast<double>(columns.get(conversion_filters[k]).width()) : 1.0;
+        }
+    }
+
+    inline bool should_sample()
+    {
+        return (_num_tests++ % sample_rate) == 0;
+    }
+
+    void sample(const Genome& genome, const LoanTypeVector& conversion_filters, const LoanColumns& columns,
+        const unsigned start_range, const unsigned end_range, std::vector<unsigned>& selection)
+    {
+        if (start_range >= end_range) {
+            return;
+        }
+
+        // The window after the previous sample, wrapping around to the start of the range
+        //
+        const unsigned range_size = end_range - start_range;
+        const unsigned window_size = std::min(range_size, sample_size);
+        const unsigned start = start_range + std::min(_sample_offset % range_size, range_size - window_size);
+        const unsigned end = start + window_size;
+        _sample_offset = (_sample_offset % range_size) + window_size;
+        selection.resize(window_size);
+
+        for (size_t k = 0, size = genome.size(); k < size; ++k) {
+            auto num_selected = ColumnScan::select(genome.get_relation(k), columns.get(conversion_filters[k]),
+                start, end, genome.get_value(k), selection.data());
+            _evaluated[k] += window_size;
+            _passed[k] += num_selected;
+        }
+    }
+
+    // Adds the counts of another tracker, used to combine the workers
+    void merge(const FilterSelectivity& other)
+    {
+        for (size_t k = 0; k < _evaluated.size(); ++k) {
+            _evaluated[k] += other._evaluated[k];
+            _passed[k] += other._passed[k];
+        }
+    }
+
+    void clear()
+    {
+        std::fill(_evaluated.begin(), _evaluated.end(), 0);
+        std::fill(_passed.begin(), _passed.end(), 0);
+    }
+
+    double pass_rate(const unsigned k) const
+    {
+        return (_evaluated[k] == 0) ? 1.0 : static_cast<double>(_passed[k]) / _evaluated[k];
+    }
+
+    // Orders the filters by how many loans they remove per byte read, then decays the counts
+    //
+    void adapt()
+    {
+        std::vector<double> rank(_order.size());
+        for (unsigned k = 0; k < rank.size(); ++k) {
+            rank[k] = (1.0 - pass_rate(k)) / _cost[k];
+        }
+
+        std::stable_sort(_order.begin(), _order.end(), [&rank](const unsigned a, const unsigned b) {
+            return rank[a] > rank[b];
+        });
+
+        for (size_t k = 0; k < _evaluated.size(); ++k) {
+            _evaluated[k] /= 2;
+            _passed[k] /= 2;
+        }
+    }
+
+    const std::vector<unsigned>& get_order() const
+    {
+        return _order;
+    }
+
+    void set_order(const std::vector<unsigned>& order)
+    {
+        _order = order;
+    }
+
+private:
+    unsigned                                    _num_tests;
+    unsigned                                    _sample_offset;         // where the next sample starts in the range
+    std::vector<std::uint64_t>                  _evaluated;
+    std::vector<std::uint64_t>                  _passed;
+    std::vector<double>                         _cost;
+    std::vector<unsigned>                       _order;
+};
+
+};
+
+#endif // __LC_FILTER_SELECTIVITY_HPP__
@@ -104,6 +104,18 @@ void construct_filter(const Loan::LoanType filter_type,
     };
 }
 
+// One filter of each of the types, in the same order
+//
+FilterPtrVector construct_filters(const LoanTypeVector& filter_types)
+{
+    FilterPtrVector filters(filter_types.size());
+    for (size_t k = 0; k < filter_types.size(); ++k) {
+        FilterPtrVector::iterator filter_it = filters.begin() + k;
+        construct_filter(filter_types[k], filter_it);
+    }
+    return filters;
+}
+
 };
 
 #endif // __LC_FILTERS_HPP__
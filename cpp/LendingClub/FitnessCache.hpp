@@ -0,0 +1,139 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_FITNESS_CACHE_HPP__
+#define __LC_FITNESS_CACHE_HPP__
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <boost/functional/hash.hpp>
+#include "Types.hpp"
+#include "Loan.hpp"
+
+namespace lc
+{
+
+//
+// Remembers the LoanReturn of the most recently tested filter sets so citizens surviving mate()
+// unchanged (the elite) are not scanned again. The key is the exact list of option indices, not a
+// hash, so a hit is always the result the backtester would have computed. Least recently used
+// entries are evicted once the cache is full.
+//
+class FitnessCache
+{
+public:
+    typedef std::vector<Gene> Key;
+
+    FitnessCache(const size_t max_size) :
+        _max_size(max_size),
+        _hits(0),
+        _misses(0),
+        _evictions(0)
+    {
+        _entries.reserve(max_size);
+    }
+
+    bool enabled() const
+    {
+        return _max_size > 0;
+    }
+
+    static void make_key(const Gene* genes, const size_t num_genes, Key& key)
+    {
+        key.assign(genes, genes + num_genes);
+    }
+
+    // Looks up key, on a hit copies the cached result into result and marks the entry most recently used
+    //
+    bool find(const Key& key, LoanReturn& result)
+    {
+        auto it = _entries.find(key);
+        if (it == _entries.end()) {
+            ++_misses;
+            return false;
+        }
+
+        ++_hits;
+        _lru.splice(_lru.begin(), _lru, it->second.second);
+        result = it->second.first;
+        return true;
+    }
+
+    void insert(const Key& key, const LoanReturn& result)
+    {
+        if (_max_size == 0) {
+            return;
+        }
+
+        auto it = _entries.find(key);
+        if (it != _entries.end()) {
+            it->second.first = result;
+            _lru.splice(_lru.begin(), _lru, it->second.second);
+            return;
+        }
+
+        if (_entries.size() >= _max_size) {
+            _entries.erase(*_lru.back());
+            _lru.pop_back();
+            ++_evictions;
+        }
+
+        auto inserted = _entries.emplace(key, std::make_pair(result, _lru.end())).first;
+        _lru.push_front(&(inserted->first));
+        inserted->second.second = _lru.begin();
+    }
+
+    size_t size() const
+    {
+        return _entries.size();
+    }
+
+    unsigned long long hits() const
+    {
+        return _hits;
+    }
+
+    unsigned long long misses() const
+    {
+        return _misses;
+    }
+
+    unsigned long long evictions() const
+    {
+        return _evictions;
+    }
+
+private:
+    struct KeyHash
+    {
+        size_t operator() (const Key& key) const
+        {
+            return boost::hash_range(key.begin(), key.end());
+        }
+    };
+
+    // The list holds pointers to the keys owned by the map, most recently used first
+    typedef std::list<const Key*> LruList;
+    typedef std::unordered_map<Key, std::pair<LoanReturn, LruList::iterator>, KeyHash> EntryMap;
+
+    size_t                                      _max_size;
+    unsigned long long                          _hits;
+    unsigned long long                          _misses;
+    unsigned long long                          _evictions;
+    LruList                                     _lru;
+    EntryMap                                    _entries;
+};
+
+};
+
+#endif // __LC_FITNESS_CACHE_HPP__
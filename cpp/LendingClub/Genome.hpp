@@ -0,0 +1,221 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_GENOME_HPP__
+#define __LC_GENOME_HPP__
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include "Types.hpp"
+#include "Loan.hpp"
+#include "Filter.hpp"
+
+namespace lc
+{
+
+//
+// Options and relation of every filter of a genome, copied out of the filters once so a genome can be
+// a plain array of option indices. Shared by all the genomes of a run, and only read once built, so
+// any number of threads can look values up at the same time.
+//
+class FilterOptionTable
+{
+public:
+    // Options a filter may have at most, its option index has to fit in a Gene
+    static const size_t max_options = static_cast<size_t>(std::numeric_limits<Gene>::max()) + 1;
+
+    FilterOptionTable(const FilterPtrVector& filters)
+    {
+        for (auto filter : filters) {
+            const FilterValueVector& options = filter->get_options();
+            if (options.empty() || (options.size() > max_options)) {
+                std::cout << "Error: " << filter->get_name() << " has " << options.size() << " options, a genome holds 1 to "
+                    << max_options << std::endl;
+                exit(-1);
+            }
+
+            _offsets.push_back(_values.size());
+            _counts.push_back(static_cast<unsigned>(options.size()));
+            _relations.push_back(filter->get_relation());
+            _names.push_back(filter->get_name());
+            _values.insert(_values.end(), options.begin(), options.end());
+        }
+    }
+
+    size_t size() const
+    {
+        return _counts.size();
+    }
+
+    inline unsigned get_count(const size_t k) const
+    {
+        return _counts[k];
+    }
+
+    inline FilterValue get_value(const size_t k, const Gene gene) const
+    {
+        return _values[_offsets[k] + gene];
+    }
+
+    inline Filter::Relation get_relation(const size_t k) const
+    {
+        return _relations[k];
+    }
+
+    const LCString& get_name(const size_t k) const
+    {
+        return _names[k];
+    }
+
+private:
+    std::vector<FilterValue>                    _values;        // the options of every filter, one filter after the other
+    std::vector<size_t>                         _offsets;       // where the options of each filter start in _values
+    std::vector<unsigned>                       _counts;
+    std::vector<Filter::Relation>               _relations;
+    StringVector                                _names;
+};
+
+//
+// One filter set as the scans see it, the option index of every filter and the table to look their
+// values up in. Only points into memory owned elsewhere, so it is cheap to pass around by value.
+//
+class Genome
+{
+public:
+    Genome(const FilterOptionTable& options, const Gene* genes) : _options(&options), _genes(genes) {}
+
+    size_t size() const
+    {
+        return _options->size();
+    }
+
+    inline Gene get_current(const size_t k) const
+    {
+        return _genes[k];
+    }
+
+    inline FilterValue get_value(const size_t k) const
+    {
+        return _options->get_value(k, _genes[k]);
+    }
+
+    inline Filter::Relation get_relation(const size_t k) const
+    {
+        return _options->get_relation(k);
+    }
+
+    const Gene* get_genes() const
+    {
+        return _genes;
+    }
+
+    const FilterOptionTable& get_options() const
+    {
+        return *_options;
+    }
+
+    // Sets each of filters, built from the same filter types as the table, to its option of this genome.
+    // For the code that calls the filters' own apply() or formats their values.
+    //
+    void load(const FilterPtrVector& filters) const
+    {
+        assert(filters.size() == size());
+        for (size_t k = 0, num_genes = size(); k < num_genes; ++k) {
+            filters[k]->set_current(_genes[k], get_value(k));
+        }
+    }
+
+private:
+    const FilterOptionTable*                    _options;
+    const Gene*                                 _genes;
+};
+
+//
+// The citizens of a GA generation. The genes of all the citizens are in one block, citizen i owning
+// the genes [i * num_genes, (i + 1) * num_genes), and their results are in another, so copying and hashing
+// citizens only ever walks contiguous memory.
+//
+class Population
+{
+public:
+    Population(const FilterOptionTable& options, const size_t size) :
+        _options(options),
+        _num_genes(options.size()),
+        _genes(size * options.size(), 0),
+        _results(size)
+    {
+    }
+
+    size_t size() const
+    {
+        return _results.size();
+    }
+
+    size_t num_genes() const
+    {
+        return _num_genes;
+    }
+
+    const FilterOptionTable& get_options() const
+    {
+        return _options;
+    }
+
+    inline Gene* get_genes(const size_t i)
+    {
+        return &_genes[i * _num_genes];
+    }
+
+    inline const Gene* get_genes(const size_t i) const
+    {
+        return &_genes[i * _num_genes];
+    }
+
+    Genome get_genome(const size_t i) const
+    {
+        return Genome(_options, get_genes(i));
+    }
+
+    inline LoanReturn& get_result(const size_t i)
+    {
+        return _results[i];
+    }
+
+    inline const LoanReturn& get_result(const size_t i) const
+    {
+        return _results[i];
+    }
+
+    // Copies citizen from_idx of a population over the same filters into citizen to_idx, genes and result
+    //
+    void copy_citizen(const Population& from, const size_t from_idx, const size_t to_idx)
+    {
+        assert(from._num_genes == _num_genes);
+        const Gene* genes = from.get_genes(from_idx);
+        std::copy(genes, genes + _num_genes, get_genes(to_idx));
+        _results[to_idx] = from._results[from_idx];
+    }
+
+private:
+    const FilterOptionTable&                    _options;
+    const size_t                                _num_genes;
+    std::vector<Gene>                           _genes;
+    std::vector<LoanReturn>                     _results;
+};
+
+};
+
+#endif // __LC_GENOME_HPP__
@@ -0,0 +1,120 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_GENOME_HASH_SET_HPP__
+#define __LC_GENOME_HASH_SET_HPP__
+
+#include <cstdint>
+#include <vector>
+#include "Types.hpp"
+
+namespace lc
+{
+
+//
+// Set of the 64 bit hashes of every filter set the GA has generated so far.
+//
+// The hash folds the option index of each filter in turn, so the same options on different filters
+// give different hashes, and finishes with an avalanche step so similar genomes do not land next to
+// each other. The set is open addressing with linear probing over a power of two table kept at most
+// half full, so lookups stay O(1) no matter how many iterations the GA runs.
+//
+class GenomeHashSet
+{
+public:
+    typedef std::uint64_t Hash;
+
+    GenomeHashSet() : _size(0), _table(1024, Hash(empty)) {}
+
+    static Hash hash(const Gene* genes, const size_t num_genes)
+    {
+        Hash result = 0xcbf29ce484222325ull;
+        for (size_t k = 0; k < num_genes; ++k) {
+            result ^= genes[k];
+            result *= 0x100000001b3ull;
+        }
+
+        // Final mixer from splitmix64
+        result ^= result >> 30;
+        result *= 0xbf58476d1ce4e5b9ull;
+        result ^= result >> 27;
+        result *= 0x94d049bb133111ebull;
+        result ^= result >> 31;
+
+        // 0 marks an empty slot
+        return (result == empty) ? 1 : result;
+    }
+
+    bool contains(const Hash hash) const
+    {
+        const size_t mask = _table.size() - 1;
+        for (size_t i = hash & mask; _table[i] != empty; i = (i + 1) & mask) {
+            if (_table[i] == hash) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns false when the hash was already in the set
+    bool insert(const Hash hash)
+    {
+        if ((_size + 1) * 2 > _table.size()) {
+            grow();
+        }
+
+        const size_t mask = _table.size() - 1;
+        size_t i = hash & mask;
+        for (; _table[i] != empty; i = (i + 1) & mask) {
+            if (_table[i] == hash) {
+                return false;
+            }
+        }
+
+        _table[i] = hash;
+        ++_size;
+        return true;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    static const Hash empty = 0;
+
+    void grow()
+    {
+        std::vector<Hash> table(_table.size() * 2, Hash(empty));
+        const size_t mask = table.size() - 1;
+
+        for (auto hash : _table) {
+            if (hash != empty) {
+                size_t i = hash & mask;
+                while (table[i] != empty) {
+                    i = (i + 1) & mask;
+                }
+                table[i] = hash;
+            }
+        }
+
+        _table.swap(table);
+    }
+
+    size_t                                      _size;
+    std::vector<Hash>                           _table;
+};
+
+};
+
+#endif // __LC_GENOME_HASH_SET_HPP__
@@ -54,7 +54,7 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
         if (raw_data == "MORTGAGE") {
             return 0;
@@ -0,0 +1,358 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#include "HugePages.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+
+using namespace lc;
+
+namespace
+{
+
+std::size_t round_to_huge_pages(const std::size_t size)
+{
+    return (size + HugePages::huge_page_size - 1) / HugePages::huge_page_size * HugePages::huge_page_size;
+}
+
+std::string to_mib(const std::size_t bytes)
+{
+    std::ostringstream out;
+    out << (bytes + 512 * 1024) / (1024 * 1024) << " MiB";
+    return out.str();
+}
+
+#ifdef __linux__
+
+// First line of a file, empty when there is none
+//
+std::string read_line(const char* path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// AnonHugePages of the whole process, what the kernel actually backed with transparent huge pages
+//
+std::string read_anon_huge_pages()
+{
+    std::ifstream in("/proc/self/smaps_rollup");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 14, "AnonHugePages:") == 0) {
+            std::istringstream fields(line.substr(14));
+            std::size_t kib = 0;
+            fields >> kib;
+            return to_mib(kib * 1024);
+        }
+    }
+    return "unknown";
+}
+
+// AnonHugePages of the mappings overlapping any of the ranges. A mapping the kernel merged with its
+// neighbours is counted whole, the caller caps the sum at the size of the ranges.
+//
+std::size_t read_anon_huge_pages(const std::vector<std::pair<std::uintptr_t, std::uintptr_t>>& ranges)
+{
+    std::ifstream in("/proc/self/smaps");
+    std::string line;
+    bool overlaps = false;
+    std::size_t bytes = 0;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string first;
+        fields >> first;
+        if (first.empty()) {
+            continue;
+        }
+
+        if (first.back() != ':') {
+            // A mapping starts with its address range, start-end in hex
+            //
+            std::uintptr_t start = 0;
+            std::uintptr_t end = 0;
+            char dash = 0;
+            std::istringstream range(first);
+            range >> std::hex >> start >> dash >> end;
+            overlaps = false;
+            for (const auto& r : ranges) {
+                overlaps = overlaps || ((r.first < end) && (start < r.second));
+            }
+        } else if (overlaps && (first == "AnonHugePages:")) {
+            std::size_t kib = 0;
+            fields >> kib;
+            bytes += kib * 1024;
+        }
+    }
+    return bytes;
+}
+
+#endif
+
+};
+
+HugePages::HugePages() :
+    _backing(Backing::HUGETLB),
+    _hugetlb_failures(0),
+    _hugetlb_errno(0)
+{
+    for (unsigned i = 0; i < NUM_OBTAINED; ++i) {
+        _blocks[i] = 0;
+        _bytes[i] = 0;
+    }
+}
+
+HugePages& HugePages::Get()
+{
+    static HugePages huge_pages;
+    return huge_pages;
+}
+
+bool HugePages::parse_backing(const std::string& name, Backing& backing)
+{
+    if (name == "none") {
+        backing = Backing::NONE;
+    } else if (name == "madvise") {
+        backing = Backing::MADVISE;
+    } else if (name == "hugetlb") {
+        backing = Backing::HUGETLB;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string HugePages::get_name(const Backing backing)
+{
+    switch (backing) {
+    case Backing::NONE:    return "none";
+    case Backing::MADVISE: return "madvise";
+    case Backing::HUGETLB: return "hugetlb";
+    }
+    return "unknown";
+}
+
+void* HugePages::allocate(const std::size_t size)
+{
+#ifdef __linux__
+    if (size >= min_mapped_size) {
+        const std::size_t mapped_size = round_to_huge_pages(size);
+        Obtained obtained = SMALL_PAGES;
+        void* p = map(mapped_size, obtained);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        Block block = { mapped_size, obtained };
+        _mapped[reinterpret_cast<std::uintptr_t>(p)] = block;
+        ++_blocks[obtained];
+        _bytes[obtained] += mapped_size;
+        return p;
+    }
+#endif
+
+    void* p = nullptr;
+#ifdef _MSC_VER
+    p = _aligned_malloc(size, heap_alignment);
+#else
+    if (posix_memalign(&p, heap_alignment, size) != 0) {
+        p = nullptr;
+    }
+#endif
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    ++_blocks[HEAP];
+    _bytes[HEAP] += size;
+    return p;
+}
+
+void HugePages::deallocate(void* p, const std::size_t size)
+{
+#ifdef __linux__
+    if (size >= min_mapped_size) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _mapped.find(reinterpret_cast<std::uintptr_t>(p));
+            if (it != _mapped.end()) {
+                --_blocks[it->second.obtained];
+                _bytes[it->second.obtained] -= it->second.mapped_size;
+                _mapped.erase(it);
+            }
+        }
+        munmap(p, round_to_huge_pages(size));
+        return;
+    }
+#endif
+
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+    --_blocks[HEAP];
+    _bytes[HEAP] -= size;
+}
+
+HugePages::PageUsage HugePages::get_usage(const Regions& regions) const
+{
+    PageUsage usage;
+    std::set<std::uintptr_t> blocks;
+    std::vector<std::pair<std::uintptr_t, std::uintptr_t>> unreserved;
+    std::size_t unreserved_bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const auto& region : regions) {
+            const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(region.first);
+            auto it = _mapped.upper_bound(start);
+            if ((it == _mapped.begin()) || (start >= std::prev(it)->first + std::prev(it)->second.mapped_size)) {
+                usage.heap_bytes += region.second;
+                continue;
+            }
+
+            --it;
+            if (!blocks.insert(it->first).second) {
+                continue;
+            }
+            usage.mapped_bytes += it->second.mapped_size;
+            if (it->second.obtained == RESERVED) {
+                usage.huge_bytes += it->second.mapped_size;
+            } else {
+                unreserved.push_back(std::make_pair(it->first, it->first + it->second.mapped_size));
+                unreserved_bytes += it->second.mapped_size;
+            }
+        }
+    }
+
+#ifdef __linux__
+    if (!unreserved.empty()) {
+        usage.huge_bytes += std::min(unreserved_bytes, read_anon_huge_pages(unreserved));
+    }
+#endif
+    return usage;
+}
+
+void* HugePages::map(const std::size_t mapped_size, Obtained& obtained)
+{
+#ifdef __linux__
+    const Backing backing = get_backing();
+
+#ifdef MAP_HUGETLB
+    if (backing == Backing::HUGETLB) {
+        void* p = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            obtained = RESERVED;
+            return p;
+        }
+        ++_hugetlb_failures;
+        _hugetlb_errno = errno;
+    }
+#endif
+
+    // Map a huge page more than needed and trim it down to a block aligned on a huge page, so all of it
+    // can be backed by transparent huge pages
+    //
+    const std::size_t reserved_size = mapped_size + huge_page_size;
+    char* base = static_cast<char*>(mmap(nullptr, reserved_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+
+    char* p = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(base) + huge_page_size - 1) & ~(huge_page_size - 1));
+    if (p != base) {
+        munmap(base, p - base);
+    }
+    if (base + reserved_size != p + mapped_size) {
+        munmap(p + mapped_size, (base + reserved_size) - (p + mapped_size));
+    }
+
+    obtained = SMALL_PAGES;
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+    if (backing == Backing::NONE) {
+        madvise(p, mapped_size, MADV_NOHUGEPAGE);
+    } else if (madvise(p, mapped_size, MADV_HUGEPAGE) == 0) {
+        obtained = TRANSPARENT;
+    }
+#endif
+    return p;
+#else
+    return nullptr;
+#endif
+}
+
+std::string HugePages::describe() const
+{
+    std::ostringstream out;
+    out << "Huge pages " << get_name(get_backing()) << ": "
+        << _blocks[RESERVED] << " blocks " << to_mib(_bytes[RESERVED]) << " on hugetlb pages, "
+        << _blocks[TRANSPARENT] << " blocks " << to_mib(_bytes[TRANSPARENT]) << " madvised for transparent huge pages, "
+        << _blocks[SMALL_PAGES] << " blocks " << to_mib(_bytes[SMALL_PAGES]) << " on 4 KiB pages, "
+        << _blocks[HEAP] << " smaller blocks " << to_mib(_bytes[HEAP]) << " from the heap";
+
+    if (_hugetlb_failures > 0) {
+        out << ", MAP_HUGETLB failed for " << _hugetlb_failures << " blocks (" << std::strerror(_hugetlb_errno)
+            << ") which fell back to madvise";
+    }
+
+#ifdef __linux__
+    out << ", transparent huge pages " << read_line("/sys/kernel/mm/transparent_hugepage/enabled") << " with "
+        << read_anon_huge_pages() << " in use";
+#endif
+    return out.str();
+}
+
+std::string HugePages::describe(const Regions& regions) const
+{
+    const PageUsage usage = get_usage(regions);
+    std::ostringstream out;
+    out << "Huge pages " << get_name(get_backing()) << ": " << to_mib(usage.huge_bytes) << " of " << to_mib(usage.mapped_bytes) << " mapped on 2 MiB pages, "
+        << to_mib(usage.heap_bytes) << " from the heap";
+
+    if (_hugetlb_failures > 0) {
+        out << ", MAP_HUGETLB failed for " << _hugetlb_failures << " blocks (" << std::strerror(_hugetlb_errno)
+            << ") which fell back to madvise";
+    }
+
+#ifdef __linux__
+    out << ", transparent huge pages " << read_line("/sys/kernel/mm/transparent_hugepage/enabled");
+#endif
+    return out.str();
+}
+
+std::string HugePages::get_page_label(const PageUsage& usage, const Backing requested)
+{
+    if (usage.huge_bytes == 0) {
+        return (requested == Backing::NONE) ? "4K pages" : "no huge pages obtained";
+    }
+    if (usage.huge_bytes >= usage.mapped_bytes) {
+        return "2M pages";
+    }
+    return to_mib(usage.huge_bytes) + " of " + to_mib(usage.mapped_bytes) + " on 2M pages";
+}
@@ -0,0 +1,174 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_HUGE_PAGES_HPP__
+#define __LC_HUGE_PAGES_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lc
+{
+
+//
+// Memory for the loan data, the columns and the bitmap index, which the scans stream through over
+// and over. Blocks of at least min_mapped_size get a mapping of their own, rounded up to and aligned
+// on huge_page_size, backed as selected by the "huge_pages" argument:
+//   hugetlb - MAP_HUGETLB pages from the reserved pool, or transparent huge pages when the pool has none
+//   madvise - transparent huge pages, asked for with madvise(MADV_HUGEPAGE)
+//   none    - 4 KiB pages, transparent huge pages are turned off for the block
+// Smaller blocks come from the heap aligned on a cache line. Huge pages are only available on Linux,
+// elsewhere every block comes from the heap.
+//
+// The counts are of the blocks still allocated. Each mapped block remembers what backed it so the
+// pages under any memory, such as the regions of a LoanData, can be told apart from what was asked for.
+//
+class HugePages
+{
+public:
+    enum class Backing : std::int8_t { NONE = 0, MADVISE = 1, HUGETLB = 2 };
+
+    static const std::size_t huge_page_size = 2 * 1024 * 1024;
+    static const std::size_t min_mapped_size = huge_page_size / 2;
+    static const std::size_t heap_alignment = 64;
+
+    static HugePages& Get();
+
+    static bool parse_backing(const std::string& name, Backing& backing);
+    static std::string get_name(const Backing backing);
+
+    // Applies to the blocks allocated from now on
+    void set_backing(const Backing backing)
+    {
+        _backing.store(backing, std::memory_order_relaxed);
+    }
+
+    Backing get_backing() const
+    {
+        return _backing.load(std::memory_order_relaxed);
+    }
+
+    // Blocks of memory in the same layout as lc::MemoryRegions
+    typedef std::vector<std::pair<const void*, std::size_t>> Regions;
+
+    // How the pages under some regions are backed. huge_bytes is what the kernel actually put on 2 MiB
+    // pages, all of a hugetlb block and the AnonHugePages of the other mapped blocks.
+    //
+    struct PageUsage
+    {
+        PageUsage() : mapped_bytes(0), huge_bytes(0), heap_bytes(0) {}
+
+        std::size_t                             mapped_bytes;
+        std::size_t                             huge_bytes;
+        std::size_t                             heap_bytes;
+    };
+
+    void* allocate(const std::size_t size);
+    void deallocate(void* p, const std::size_t size);
+
+    PageUsage get_usage(const Regions& regions) const;
+
+    // What the blocks still allocated are backed with, and the transparent huge page setting
+    std::string describe() const;
+
+    // What the blocks under the regions are backed with
+    std::string describe(const Regions& regions) const;
+
+    // "4K pages", "2M pages" or how much is on huge pages, "no huge pages obtained" when huge pages were
+    // asked for and none of the regions got any
+    static std::string get_page_label(const PageUsage& usage, const Backing requested);
+
+private:
+    HugePages();
+
+    enum Obtained { HEAP = 0, SMALL_PAGES = 1, TRANSPARENT = 2, RESERVED = 3, NUM_OBTAINED = 4 };
+
+    struct Block
+    {
+        std::size_t                             mapped_size;
+        Obtained                                obtained;
+    };
+
+    void* map(const std::size_t mapped_size, Obtained& obtained);
+
+    std::atomic<Backing>                        _backing;
+    mutable std::mutex                          _mutex;                 // guards _mapped
+    std::map<std::uintptr_t, Block>             _mapped;                // the mapped blocks by start address
+    std::atomic<std::size_t>                    _blocks[NUM_OBTAINED];
+    std::atomic<std::size_t>                    _bytes[NUM_OBTAINED];
+    std::atomic<std::size_t>                    _hugetlb_failures;      // blocks MAP_HUGETLB could not back
+    std::atomic<int>                            _hugetlb_errno;
+};
+
+// Allocator putting a container on HugePages
+//
+template<typename T>
+class HugePageAllocator
+{
+public:
+    typedef T                   value_type;
+    typedef T*                  pointer;
+    typedef const T*            const_pointer;
+    typedef T&                  reference;
+    typedef const T&            const_reference;
+    typedef std::size_t         size_type;
+    typedef std::ptrdiff_t      difference_type;
+
+    template<typename U> struct rebind { typedef HugePageAllocator<U> other; };
+
+    HugePageAllocator() {}
+    template<typename U> HugePageAllocator(const HugePageAllocator<U>&) {}
+
+    pointer allocate(size_type n)
+    {
+        return (n == 0) ? nullptr : static_cast<pointer>(HugePages::Get().allocate(n * sizeof(T)));
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (p != nullptr) {
+            HugePages::Get().deallocate(p, n * sizeof(T));
+        }
+    }
+
+    size_type max_size() const
+    {
+        return static_cast<size_type>(-1) / sizeof(T);
+    }
+
+    template<typename U, typename... Args> void construct(U* p, Args&&... args)
+    {
+        ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U> void destroy(U* p)
+    {
+        p->~U();
+    }
+};
+
+template<typename T, typename U>
+inline bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return true; }
+
+template<typename T, typename U>
+inline bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return false; }
+
+};
+
+#endif // __LC_HUGE_PAGES_HPP__
@@ -16,10 +16,25 @@ Created on July 27, 2014
 #include <vector>
 #include <string>
 #include <cmath>
-#include <future>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <numeric>
+#include <map>
+#include <memory>
+#include <thread>
 #include <malloc.h>
 #include "Loan.hpp"
 #include "LoanData.hpp"
+#include "NumaPlacement.hpp"
+#include "CpuTopology.hpp"
+#include "FilterKernels.hpp"
+#include "FilterPipeline.hpp"
+#include "FilterSelectivity.hpp"
+#include "Genome.hpp"
+#include "Utilities.hpp"
+#include "WorkStealingPool.hpp"
 
 namespace lc
 {
@@ -27,16 +42,81 @@ namespace lc
 class LCBT
 {
 public:
+    // How process_loans walks the loans, selected by the "scan" argument
+    //
+    enum class ScanMode : std::int8_t { VIRTUAL = 0, SWITCH = 1, BITMAP = 2, COLUMNAR = 3, SIMD = 4, TEMPLATE = 5 };
+
+    // How ParallelManagerLCBT splits the work, selected by the "parallel" argument: every worker scans its
+    // own range of loans for each citizen, or every worker scans all the loans for its own citizens
+    //
+    enum class ParallelMode : std::int8_t { RANGE = 0, POPULATION = 1 };
+
+    // Number of rows the columnar scan narrows down at a time, small enough for the selection to stay in L1
+    static const unsigned column_block_size = 4096;
+
+    // Number of loans every citizen of a batch is tested against before moving on to the next loans
+    static const unsigned batch_tile_size = 4096;
+
+    static bool parse_scan_mode(const LCString& name, ScanMode& scan_mode)
+    {
+        if (name == "virtual") {
+            scan_mode = ScanMode::VIRTUAL;
+        } else if (name == "switch") {
+            scan_mode = ScanMode::SWITCH;
+        } else if (name == "bitmap") {
+            scan_mode = ScanMode::BITMAP;
+        } else if (name == "columnar") {
+            scan_mode = ScanMode::COLUMNAR;
+        } else if (name == "simd") {
+            scan_mode = ScanMode::SIMD;
+        } else if (name == "template") {
+            scan_mode = ScanMode::TEMPLATE;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static bool parse_parallel_mode(const LCString& name, ParallelMode& parallel_mode)
+    {
+        if (name == "range") {
+            parallel_mode = ParallelMode::RANGE;
+        } else if (name == "population") {
+            parallel_mode = ParallelMode::POPULATION;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static LCString get_scan_mode_name(const ScanMode scan_mode)
+    {
+        switch (scan_mode) {
+        case ScanMode::VIRTUAL:  return "virtual";
+        case ScanMode::SWITCH:   return "switch";
+        case ScanMode::BITMAP:   return "bitmap";
+        case ScanMode::COLUMNAR: return "columnar";
+        case ScanMode::SIMD:     return "simd";
+        case ScanMode::TEMPLATE: return "template";
+        }
+        return "unknown";
+    }
+
     LCBT(const LoanTypeVector& conversion_filters, const int worker_idx) :
         _conversion_filters(conversion_filters),
         _args(LCArguments::Get()),
-        _filters(conversion_filters.size()),		
+        _filters(construct_filters(conversion_filters)),
         _loan_data(NULL),
         _worker_idx(worker_idx),
         _start_range(0),
         _end_range(0)
     {
         _verbose = _args["verbose"].as<bool>();
+        _self_check = _args["self_check"].as<bool>();
+        _adaptive_order = (_args["filter_order"].as<LCString>() == "adaptive");
+        _batch_size = _args["batch_size"].as<unsigned>();
+        parse_scan_mode(_args["scan"].as<LCString>(), _scan_mode);
+        FilterKernels::parse_isa(_args["simd"].as<LCString>(), _isa);
     }
 
     virtual void initialize()
@@ -47,15 +127,74 @@ public:
         _loan_data->initialize();
         _start_range = 0;
         _end_range = _loan_data->num_loans();
+        initialize_selectivity();
+
+        if (_scan_mode == ScanMode::SIMD) {
+            _loan_data->info_msg("Using " + FilterKernels::get_name(_isa) + " filter kernels");
+        }
+
+        pin_threads();
+    }
+
+    // Only the columnar and simd scans read whole columns, their filters cost the width of their column
+    //
+    void initialize_selectivity()
+    {
+        _selectivity.initialize(_conversion_filters, _loan_data->get_columns(),
+            (_scan_mode == ScanMode::COLUMNAR) || (_scan_mode == ScanMode::SIMD));
     }
 
-    virtual void old_process_loans(FilterPtrVector& test_filters)
+    // Lays the test threads out on the cpus by the "affinity" argument and pins this thread, which is
+    // thread 0, to its cpu. Done after the load so the load threads are free to run anywhere.
+    //
+    void pin_threads()
+    {
+        const auto& topology = CpuTopology::Get();
+        const unsigned num_threads = std::max(1u, _args["workers"].as<unsigned>());
+
+        CpuTopology::Affinity affinity = CpuTopology::Affinity::NONE;
+        CpuTopology::parse_affinity(_args["affinity"].as<LCString>(), affinity);
+        std::vector<int> cpu_list;
+        CpuTopology::parse_cpu_list(_args["cpu_list"].as<LCString>(), cpu_list);
+
+        LCString error;
+        if (!topology.assign(affinity, cpu_list, num_threads, _thread_cpus, error)) {
+            _loan_data->info_msg("error: " + error);
+            exit(-1);
+        }
+
+        _loan_data->info_msg("Affinity " + CpuTopology::get_name(affinity) + ", " +
+            boost::lexical_cast<LCString>(topology.get_cpus().size()) + " cpus on " +
+            boost::lexical_cast<LCString>(topology.num_packages()) + " packages and " +
+            boost::lexical_cast<LCString>(topology.num_nodes()) + " nodes");
+        for (unsigned i = 0; i < _thread_cpus.size(); ++i) {
+            _loan_data->info_msg("Thread " + boost::lexical_cast<LCString>(i) + " on " + topology.describe(_thread_cpus[i]));
+        }
+
+        if (!_thread_cpus.empty() && !CpuTopology::pin_current_thread(_thread_cpus[0])) {
+            _loan_data->info_msg("Could not pin thread 0, threads are not pinned");
+            _thread_cpus.clear();
+        }
+    }
+
+    virtual void old_process_loans(const Genome& genome)
     {
         _invested.clear();
 
-        unsigned num_filters = test_filters.size();
+        // The reference scan calls every filter's own apply(), so it runs on this LCBT's filters set to the genome
+        //
+        genome.load(_filters);
+        unsigned num_filters = _filters.size();
 
-        auto first_filter_p = &(test_filters[0]);
+        // Evaluated in the learned order, so the loop gives up on a loan at the most selective filter first
+        //
+        Filter** ordered_filters = static_cast<Filter**>(alloca(num_filters * sizeof(Filter*)));
+        const auto& order = _selectivity.get_order();
+        for (unsigned j = 0; j < num_filters; ++j) {
+            ordered_filters[j] = _filters[order[j]];
+        }
+
+        auto first_filter_p = &(ordered_filters[0]);
 
         auto& loans = _loan_data->get_loans();
         const Loan* loan = &(loans[_start_range]);
@@ -74,7 +213,7 @@ public:
     }
 
 
-    virtual void process_loans(FilterPtrVector& test_filters)
+    virtual void process_loans(const Genome& genome)
     {        
         //
         // What I want this algorithm to do is convert all relations to a linear code so that we don't have to
@@ -91,33 +230,44 @@ public:
 
         _invested.clear();
 
-        unsigned num_filters = test_filters.size();
+        unsigned num_filters = genome.size();
+
+        // The filters are evaluated in the learned order, filter k still reads the k-th value of the loan
+        //
+        const auto& order = _selectivity.get_order();
 
         FilterValue* filter_values = static_cast<FilterValue*>(alloca(num_filters * sizeof(FilterValue)));
-        for (unsigned i = 0, size = num_filters; i < size; ++i) {
-            filter_values[i] = test_filters[i]->get_value();
+        for (unsigned j = 0, size = num_filters; j < size; ++j) {
+            filter_values[j] = genome.get_value(order[j]);
         }
 
         Filter::Relation* relations = static_cast<Filter::Relation*>(alloca(num_filters * sizeof(Filter::Relation)));
-        for (unsigned i = 0, size = num_filters; i < size; ++i) {
-            relations[i] = test_filters[i]->get_relation();
+        for (unsigned j = 0, size = num_filters; j < size; ++j) {
+            relations[j] = genome.get_relation(order[j]);
+        }
+
+        unsigned* loan_value_idx = static_cast<unsigned*>(alloca(num_filters * sizeof(unsigned)));
+        for (unsigned j = 0, size = num_filters; j < size; ++j) {
+            loan_value_idx[j] = order[j];
         }
 
         auto first_relation_p = &(relations[0]);
-        auto first_filter_p = &(test_filters[0]);
         auto first_filter_value_p = &(filter_values[0]);
+        auto first_loan_value_idx_p = &(loan_value_idx[0]);
 
         auto& loans = _loan_data->get_loans();
         const Loan* loan = &(loans[_start_range]);        
 
         for (auto i = _start_range; i < _end_range; ++i, ++loan) {
 
-            const LoanValue* loan_data_value_p = &(loan->acc_open_past_24mths);
+            const LoanValue* loan_data_values = &(loan->acc_open_past_24mths);
             auto filter_value_p = first_filter_value_p;
             auto relation_value_p = first_relation_p;
+            auto loan_value_idx_p = first_loan_value_idx_p;
 
             LoanValue filter_matches = 1;
-            for (unsigned k = num_filters; k != 0 && filter_matches; --k, ++relation_value_p, ++loan_data_value_p, ++filter_value_p) {
+            for (unsigned k = num_filters; k != 0 && filter_matches; --k, ++relation_value_p, ++loan_value_idx_p, ++filter_value_p) {
+                const LoanValue* loan_data_value_p = &(loan_data_values[*loan_value_idx_p]);
                 switch (*relation_value_p) {
                 case Filter::Relation::LESS_THAN_EQUAL:    filter_matches = ((*loan_data_value_p) <= (*filter_value_p)); break;
                 case Filter::Relation::LESS_THAN:          filter_matches = ((*loan_data_value_p) <  (*filter_value_p)); break;
@@ -135,10 +285,432 @@ public:
         }
     }
 
-    virtual LoanReturn test(FilterPtrVector& test_filters)
+    // Leaves the match mask of the current range in _selected, returns false when nothing matched
+    //
+    bool select_bitmap(const Genome& genome)
+    {
+        if (_start_range >= _end_range) {
+            return false;
+        }
+
+        // The ranges given to the workers always start on a word boundary of the bitmap index
+        //
+        const auto& bitmap_index = _loan_data->get_bitmap_index();
+        assert(_start_range % LoanBitmapIndex::bits_per_word == 0);
+
+        unsigned first_word = _start_range / LoanBitmapIndex::bits_per_word;
+        unsigned last_word = LoanBitmapIndex::words_for(_end_range);
+        _selected.resize(last_word - first_word);
+
+        return bitmap_index.select(genome, _selectivity.get_order(), first_word, last_word, _selected.data());
+    }
+
+    virtual void process_loans_bitmap(const Genome& genome)
+    {
+        _invested.clear();
+
+        if (select_bitmap(genome)) {
+            append_selected();
+        }
+    }
+
+    // Hands every block of loans matched in the current range to sink(selection, num_selected)
+    //
+    template<typename Sink>
+    void select_columnar(const Genome& genome, Sink sink)
+    {
+        // Each filter is matched against its own column, found through the conversion filters, so unlike
+        // process_loans this does not depend on the layout of the Loan struct
+        //
+        unsigned num_filters = genome.size();
+        const auto& columns = _loan_data->get_columns();
+
+        const LoanColumn** filter_columns = static_cast<const LoanColumn**>(alloca(num_filters * sizeof(LoanColumn*)));
+        FilterValue* filter_values = static_cast<FilterValue*>(alloca(num_filters * sizeof(FilterValue)));
+        Filter::Relation* relations = static_cast<Filter::Relation*>(alloca(num_filters * sizeof(Filter::Relation)));
+        const auto& order = _selectivity.get_order();
+        for (unsigned j = 0; j < num_filters; ++j) {
+            unsigned k = order[j];
+            filter_columns[j] = &(columns.get(_conversion_filters[k]));
+            filter_values[j] = genome.get_value(k);
+            relations[j] = genome.get_relation(k);
+        }
+
+        _selection.resize(column_block_size);
+        unsigned* selection = _selection.data();
+
+        for (unsigned block_start = _start_range; block_start < _end_range; block_start += column_block_size) {
+            unsigned block_end = std::min(_end_range, block_start + column_block_size);
+
+            unsigned num_selected = ColumnScan::select(relations[0], *filter_columns[0], block_start, block_end, filter_values[0], selection);
+            for (unsigned k = 1; k < num_filters && num_selected != 0; ++k) {
+                num_selected = ColumnScan::refine(relations[k], *filter_columns[k], num_selected, filter_values[k], selection);
+            }
+
+            sink(selection, num_selected);
+        }
+    }
+
+    virtual void process_loans_columnar(const Genome& genome)
+    {
+        _invested.clear();
+
+        select_columnar(genome, [this](const unsigned* selection, const unsigned num_selected) {
+            _invested.insert(_invested.end(), selection, selection + num_selected);
+        });
+    }
+
+    // Leaves the match mask of the current range in _selected, returns false when nothing matched
+    //
+    bool select_simd(const Genome& genome)
+    {
+        if (_start_range >= _end_range) {
+            return false;
+        }
+
+        // Same word aligned ranges as the bitmap index, one mask bit per loan
+        //
+        assert(_start_range % FilterKernels::rows_per_word == 0);
+        const auto& columns = _loan_data->get_columns();
+
+        unsigned first_word = _start_range / FilterKernels::rows_per_word;
+        unsigned num_words = (_end_range + FilterKernels::rows_per_word - 1) / FilterKernels::rows_per_word - first_word;
+        _selected.assign(num_words, ~std::uint64_t(0));
+
+        // Rows past the last loan are only padding in the columns
+        //
+        unsigned tail = _end_range % FilterKernels::rows_per_word;
+        if (tail != 0) {
+            _selected.back() = (std::uint64_t(1) << tail) - 1;
+        }
+
+        for (auto k : _selectivity.get_order()) {
+            auto any = FilterKernels::and_matches(_isa, genome.get_relation(k), columns.get(_conversion_filters[k]),
+                first_word, num_words, genome.get_value(k), _selected.data());
+            if (any == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    virtual void process_loans_simd(const Genome& genome)
     {
-        process_loans(test_filters);
-        return get_loan_data().get_nar(_invested);
+        _invested.clear();
+
+        if (select_simd(genome)) {
+            append_selected();
+        }
+    }
+
+    // Appends the rowids set in the _selected mask of the current range to _invested
+    //
+    void append_selected()
+    {
+        unsigned rowid = _start_range;
+        for (auto word : _selected) {
+            while (word != 0) {
+                _invested.push_back(rowid + count_trailing_zeros(word));
+                word &= word - 1;
+            }
+            rowid += LoanBitmapIndex::bits_per_word;
+        }
+    }
+
+    virtual void process_loans_template(const Genome& genome)
+    {
+        // Only valid for the standard 18 filter configuration, lcmain checks this before selecting it. The
+        // pipeline is a chain fixed at compile time, it always evaluates the filters in their declared order
+        // and does not follow the learned order.
+        //
+        assert(genome.size() == StandardFilterPipeline::size);
+
+        _invested.clear();
+
+        if (_start_range >= _end_range) {
+            return;
+        }
+
+        // The stages call each filter's apply() directly, on this LCBT's filters set to the genome
+        //
+        genome.load(_filters);
+        Filter* const* filters = _filters.data();
+        auto& loans = _loan_data->get_loans();
+        const Loan* loan = &(loans[_start_range]);
+
+        // Write every rowid and only keep the matching ones, no branch on the result
+        //
+        _invested.resize(_end_range - _start_range);
+        LoanValue* invested = _invested.data();
+        unsigned num_matched = 0;
+
+        for (auto i = _start_range; i < _end_range; ++i, ++loan) {
+            invested[num_matched] = loan->rowid;
+            num_matched += StandardFilterPipeline::apply(filters, *loan);
+        }
+
+        _invested.resize(num_matched);
+    }
+
+    // Runs the reference old_process_loans over the same range and makes sure the current scan mode
+    // matched exactly the same loans
+    //
+    void self_check(const Genome& genome)
+    {
+        LoanValueVector scanned;
+        scanned.swap(_invested);
+        old_process_loans(genome);
+
+        if (scanned != _invested) {
+            std::cout << "Worker[" << _worker_idx << "] self check failed, matched " << scanned.size() << " loans, expected "
+                << _invested.size() << " for filters:";
+
+            // old_process_loans left the filters set to the genome
+            for (auto& filter : _filters) {
+                std::cout << ' ' << filter->get_name() << '=' << filter->get_string_value();
+            }
+            std::cout << std::endl;
+            exit(-1);
+        }
+    }
+
+    void sample_selectivity(const Genome& genome)
+    {
+        if (_adaptive_order && _selectivity.should_sample()) {
+            _selectivity.sample(genome, _conversion_filters, _loan_data->get_columns(), _start_range, _end_range, _selection);
+        }
+    }
+
+    void scan_loans(const Genome& genome)
+    {
+        sample_selectivity(genome);
+        scan_range(genome);
+    }
+
+    // Matches the loans of the current range with the current scan mode, leaves the rowids in _invested
+    //
+    void scan_range(const Genome& genome)
+    {
+        switch (_scan_mode) {
+        case ScanMode::VIRTUAL: old_process_loans(genome); break;
+        case ScanMode::SWITCH:  process_loans(genome); break;
+        case ScanMode::BITMAP:  process_loans_bitmap(genome); break;
+        case ScanMode::COLUMNAR: process_loans_columnar(genome); break;
+        case ScanMode::SIMD:    process_loans_simd(genome); break;
+        case ScanMode::TEMPLATE: process_loans_template(genome); break;
+        }
+
+        if (_self_check) {
+            self_check(genome);
+        }
+    }
+
+    // Times every scan mode over the same random filter sets on this LCBT's range of loans
+    //
+    void benchmark(const unsigned num_genomes)
+    {
+        FilterOptionTable options(_filters);
+        Population genomes(options, num_genomes);
+        for (unsigned i = 0; i < num_genomes; ++i) {
+            Gene* genes = genomes.get_genes(i);
+            for (size_t k = 0; k < options.size(); ++k) {
+                genes[k] = static_cast<Gene>(randint(0, options.get_count(k) - 1));
+            }
+        }
+
+        benchmark_scans(genomes, "");
+
+        // The same scans over copies of the loan data on 4 KiB pages and on huge pages, each labelled with
+        // the pages the copy actually got
+        //
+        LoanData* loaded = _loan_data;
+        const HugePages::Backing saved_backing = HugePages::Get().get_backing();
+        const HugePages::Backing backings[] = { HugePages::Backing::NONE,
+            (saved_backing == HugePages::Backing::NONE) ? HugePages::Backing::HUGETLB : saved_backing };
+
+        for (auto backing : backings) {
+            HugePages::Get().set_backing(backing);
+            std::unique_ptr<LoanData> copy(loaded->replicate());
+            _loan_data = copy.get();
+            HugePages::PageUsage usage = HugePages::Get().get_usage(copy->get_memory_regions());
+            benchmark_scans(genomes, ' ' + HugePages::get_page_label(usage, backing));
+        }
+
+        _loan_data = loaded;
+        HugePages::Get().set_backing(saved_backing);
+        std::cout << HugePages::Get().describe() << '\n';
+    }
+
+    // Times every scan mode over the genomes
+    //
+    void benchmark_scans(const Population& genomes, const LCString& label)
+    {
+        const ScanMode scan_modes[] = { ScanMode::VIRTUAL, ScanMode::SWITCH, ScanMode::TEMPLATE, ScanMode::COLUMNAR,
+            ScanMode::SIMD, ScanMode::BITMAP };
+        const ScanMode saved_scan_mode = _scan_mode;
+
+        for (auto scan_mode : scan_modes) {
+            if ((scan_mode == ScanMode::TEMPLATE) && !StandardFilterPipeline::matches(_conversion_filters)) {
+                continue;
+            }
+
+            _scan_mode = scan_mode;
+            size_t num_matched = 0;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < genomes.size(); ++i) {
+                scan_loans(genomes.get_genome(i));
+                num_matched += _invested.size();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+            std::cout << "Benchmark " << std::setw(8) << get_scan_mode_name(scan_mode) << label << ' ' << std::setprecision(4)
+                << (elapsed.count() * 1e6 / genomes.size()) << " usec/test, matched " << num_matched << " loans\n";
+        }
+
+        _scan_mode = saved_scan_mode;
+    }
+
+    // Scans the loans for every citizen in the batch, one tile of loans at a time with all the citizens
+    // tested against a tile before moving to the next, so the tile stays in cache instead of streaming
+    // the whole range once per citizen. Leaves the sums of the loans matched by each citizen in _batch_sums.
+    //
+    void scan_batch(const Population& population, const std::vector<unsigned>& citizens)
+    {
+        const unsigned start_range = _start_range;
+        const unsigned end_range = _end_range;
+
+        _batch_sums.assign(citizens.size(), LoanReturnSums());
+        for (size_t c = 0; c < citizens.size(); ++c) {
+            sample_selectivity(population.get_genome(citizens[c]));
+        }
+
+        // The tile size is a multiple of 64 so every tile starts on a bitmap index word
+        //
+        for (unsigned tile_start = start_range; tile_start < end_range; tile_start += batch_tile_size) {
+            set_range(tile_start, std::min(end_range, tile_start + batch_tile_size));
+
+            for (size_t c = 0; c < citizens.size(); ++c) {
+                sum_range(population.get_genome(citizens[c]), _batch_sums[c]);
+            }
+        }
+
+        set_range(start_range, end_range);
+    }
+
+    // Matches the loans of the current range and adds the ones matched to sums. The bitmap, simd and
+    // columnar scans add them straight from their masks and selections without listing their rowids,
+    // the other scans (and any scan under --self_check) go through _invested.
+    //
+    void sum_range(const Genome& genome, LoanReturnSums& sums)
+    {
+        const auto& metrics = _loan_data->get_metrics();
+
+        if (_self_check) {
+            scan_range(genome);
+            metrics.add_invested(_invested, sums);
+            return;
+        }
+
+        switch (_scan_mode) {
+        case ScanMode::BITMAP:
+            if (select_bitmap(genome)) {
+                metrics.add_masked(_selected.data(), _selected.size(), _start_range, sums);
+            }
+            break;
+        case ScanMode::SIMD:
+            if (select_simd(genome)) {
+                metrics.add_masked(_selected.data(), _selected.size(), _start_range, sums);
+            }
+            break;
+        case ScanMode::COLUMNAR:
+            select_columnar(genome, [&metrics, &sums](const unsigned* selection, const unsigned num_selected) {
+                metrics.add_selected(selection, num_selected, sums);
+            });
+            break;
+        default:
+            scan_range(genome);
+            metrics.add_invested(_invested, sums);
+            break;
+        }
+    }
+
+    // Scans the loans and sums up the ones matched into _sums
+    //
+    void sum_loans(const Genome& genome)
+    {
+        sample_selectivity(genome);
+        _sums = LoanReturnSums();
+        sum_range(genome, _sums);
+    }
+
+    virtual LoanReturn test(const Genome& genome)
+    {
+        sum_loans(genome);
+        return get_loan_data().get_nar(_sums);
+    }
+
+    // Row ids of the loans matched by genome, test() does not list them so this scans again
+    //
+    virtual void collect_invested(const Genome& genome, LoanValueVector& invested)
+    {
+        scan_range(genome);
+        invested = _invested;
+    }
+
+    // Tests the given citizens of the population, writing each result into population.get_result(i). The citizens
+    // are scanned batch_size at a time, with a batch size of 0 every citizen goes through test() on its own.
+    //
+    virtual void test_batch(Population& population, const std::vector<unsigned>& citizens)
+    {
+        if (_batch_size == 0) {
+            for (auto i : citizens) {
+                population.get_result(i) = test(population.get_genome(i));
+            }
+            return;
+        }
+
+        std::vector<unsigned> batch;
+        for (size_t start = 0; start < citizens.size(); start += _batch_size) {
+            batch.assign(citizens.begin() + start, citizens.begin() + std::min(citizens.size(), start + _batch_size));
+            scan_batch(population, batch);
+
+            for (size_t c = 0; c < batch.size(); ++c) {
+                population.get_result(batch[c]) = get_loan_data().get_nar(_batch_sums[c]);
+            }
+        }
+    }
+
+    void test_batch(Population& population)
+    {
+        std::vector<unsigned> citizens(population.size());
+        std::iota(citizens.begin(), citizens.end(), 0);
+        test_batch(population, citizens);
+    }
+
+    // Called by the GA once every citizen of an iteration has been tested
+    //
+    virtual void end_iteration()
+    {
+        if (_adaptive_order) {
+            _selectivity.adapt();
+            print_filter_order();
+        }
+    }
+
+    void print_filter_order()
+    {
+        if (!_verbose) {
+            return;
+        }
+
+        std::ostringstream out;
+        out << "Filter order:";
+        for (auto k : _selectivity.get_order()) {
+            out << ' ' << _loan_data->get_filter_name(_conversion_filters[k]) << '(' << std::setprecision(3)
+                << 100.0 * _selectivity.pass_rate(k) << "%)";
+        }
+        debug_msg(out.str());
     }
 
     virtual void finish()
@@ -171,6 +743,16 @@ public:
         return _worker_idx;
     }
 
+    unsigned get_batch_size() const
+    {
+        return _batch_size;
+    }
+
+    FilterSelectivity& get_selectivity()
+    {
+        return _selectivity;
+    }
+
     void set_range(unsigned start_range, unsigned end_range)
     {
         _start_range = start_range;
@@ -182,38 +764,53 @@ public:
         return _invested;
     }
 
+    const LoanReturnSums& get_sums() const
+    {
+        return _sums;
+    }
+
+    const std::vector<LoanReturnSums>& get_batch_sums() const
+    {
+        return _batch_sums;
+    }
+
+    // The cpu of every test thread, empty when they are not pinned
+    const std::vector<int>& get_thread_cpus() const
+    {
+        return _thread_cpus;
+    }
+
 private:
     const LoanTypeVector&                   _conversion_filters;
     const Arguments&                        _args;
     bool                                    _verbose;
-    FilterPtrVector                         _filters;
+    bool                                    _self_check;
+    bool                                    _adaptive_order;
+    unsigned                                _batch_size;
+    ScanMode                                _scan_mode;
+    FilterKernels::Isa                      _isa;
+    FilterPtrVector                         _filters;               // set to the genome by the scans calling the filters' apply()
     const int                               _worker_idx;
     unsigned                                _start_range;
     unsigned                                _end_range;
     LoanData*                               _loan_data;
     LoanValueVector                         _invested;
-};
-
-class ParallelWorkerLCBT;
-
-struct LCBT_ThreadData {
-    ParallelWorkerLCBT*                     lcbt = nullptr;
-    FilterPtrVector*                        test_filters = nullptr;
-    std::thread*                            t = nullptr;                // The thread object
-    std::condition_variable                 cv;                         // The condition variable to wait for threads
-    std::mutex                              m;                          // Mutex used for avoiding data races
-    std::promise<bool>                      p;                          // use to indicate completion back to the managing thread
-    std::future<bool>                       f;                          // future which holds the promise
-    bool                                    stop = false;               // When set, this flag tells the thread that it should exit
-    bool                                    process_loans = false;      // When set, this flag tells the thread to process loans
+    LoanReturnSums                          _sums;
+    std::vector<LoanReturnSums>             _batch_sums;
+    LoanBitmapIndex::WordVector             _selected;
+    std::vector<unsigned>                   _selection;
+    FilterSelectivity                       _selectivity;
+    std::vector<int>                        _thread_cpus;
 };
 
 class ParallelWorkerLCBT : public LCBT
 {
 public:
     ParallelWorkerLCBT(const LoanTypeVector& conversion_filters, const int worker_idx) : LCBT(conversion_filters, worker_idx),
+        _conversion_filters(conversion_filters),
         _args(LCArguments::Get())
     {
+        parse_parallel_mode(_args["parallel"].as<LCString>(), _parallel_mode);
     }
 
     virtual void initialize() {
@@ -222,12 +819,23 @@ public:
         auto& loans = get_loan_data().get_loans();
         auto num_loans = loans.size();
 
+        initialize_selectivity();
+
+        // In population mode every worker scans all the loans for its own citizens
+        //
+        if (_parallel_mode == ParallelMode::POPULATION) {
+            set_range(0, num_loans);
+            return;
+        }
+
         // Split up the work among all the threads
         // we use ceil here to so that at worst case end range is a bit over the number of loans
+        // and round up to a whole bitmap index word so no two workers share a word
         //
         auto work_size = static_cast<size_t>(std::ceil(static_cast<double>(num_loans) / _args["workers"].as<unsigned>()));
+        work_size = LoanBitmapIndex::words_for(work_size) * LoanBitmapIndex::bits_per_word;
 
-        auto start_range = work_size * get_worker_idx();
+        auto start_range = std::min(num_loans, work_size * get_worker_idx());
 
         // This makes sure we do not ever go past the number of loans
         //
@@ -236,42 +844,19 @@ public:
         set_range(start_range, end_range);
     }
 
-    // The thread function executed by each worker thread
+    // Population mode, tests the citizens [start, end) of the list
     //
-    static void work_function(LCBT_ThreadData* thread_data)
+    void test_citizens(Population& population, const std::vector<unsigned>& citizens, const size_t start, const size_t end)
     {
-        std::unique_lock<std::mutex> l(thread_data->m, std::defer_lock);
-
-        while (true) {
-            l.lock();
-
-            // Wait until this thread should process loans or stop
-            thread_data->cv.wait(l, [thread_data]() {
-                return (thread_data->process_loans || thread_data->stop);
-            });
-
-            // If we are done with work, finish up
-            //
-            if (thread_data->stop) { return; }
-
-            // Clear the flag which tells us to process the loans
-            thread_data->process_loans = false;
-
-            // We are done modifying thread state
-            l.unlock();
-
-            // Process our set of loans
-            thread_data->lcbt->process_loans(*thread_data->test_filters);
-
-            // Indicate back we are done with work by updating the promise
-            //
-            thread_data->p.set_value(true);
-        }
+        _citizens.assign(citizens.begin() + start, citizens.begin() + end);
+        test_batch(population, _citizens);
     }
 
 private:
+    const LoanTypeVector&                   _conversion_filters;
     const Arguments&                        _args;
-    FilterPtrVector*                        _test_filters;
+    ParallelMode                            _parallel_mode;
+    std::vector<unsigned>                   _citizens;
 };
 
 
@@ -280,8 +865,11 @@ class ParallelManagerLCBT : public LCBT
 public:
     ParallelManagerLCBT(const LoanTypeVector& conversion_filters) : LCBT(conversion_filters, -1),
         _conversion_filters(conversion_filters),
-        _num_workers(LCArguments::Get()["workers"].as<unsigned>())
+        _num_workers(LCArguments::Get()["workers"].as<unsigned>()),
+        _work_batch(LCArguments::Get()["work_batch"].as<unsigned>())
     {
+        parse_parallel_mode(LCArguments::Get()["parallel"].as<LCString>(), _parallel_mode);
+        NumaPlacement::parse_mode(LCArguments::Get()["numa"].as<LCString>(), _numa_mode);
     }
 
     virtual void initialize()
@@ -289,87 +877,202 @@ public:
         // Initialize the data
         LCBT::initialize();
 
-        LoanData* loan_data = const_cast<LoanData*>(&get_loan_data());
-
-        _threads.resize(_num_workers);
+        place_loan_data(const_cast<LoanData*>(&get_loan_data()));
 
+        // One worker per pool thread, in range mode worker i owns the i-th range of loans and in population
+        // mode it holds the scratch state of pool thread i. A range task scans the loan data of the thread
+        // running it, which may have stolen it from another node.
+        //
         for (size_t i = 0; i < _num_workers; ++i) {            
-            _threads[i] = new LCBT_ThreadData;
+            auto lcbt = new ParallelWorkerLCBT(_conversion_filters, i);
+            lcbt->set_loan_data(_thread_loan_data[i]);
+            lcbt->initialize();
+            _workers.push_back(lcbt);
+        }
 
-            auto& td = *(_threads[i]);
+        // Started once the data is loaded so the load does not count as idle time
+        //
+        _pool.reset(new WorkStealingPool(_num_workers, get_thread_cpus()));
+    }
 
-            // Create all the workers
-            //
-            td.lcbt = new ParallelWorkerLCBT(_conversion_filters, i);
+    virtual LoanReturn test(const Genome& genome)
+    {
+        // The workers each own whole citizens in population mode, a lone citizen is tested right here
+        //
+        if (_parallel_mode == ParallelMode::POPULATION) {
+            return LCBT::test(genome);
+        }
 
-            // Set their data pointer
-            //
-            td.lcbt->set_loan_data(loan_data);
+        // One task per range of loans, each worker sums up the loans it matched
+        //
+        auto scan = [this, &genome](unsigned worker_idx, unsigned task) {
+            _workers[task]->set_loan_data(_thread_loan_data[worker_idx]);
+            _workers[task]->sum_loans(genome);
+        };
+        _pool->run(_num_workers, scan);
+
+        LoanReturnSums sums;
+        for (auto worker : _workers) {
+            sums += worker->get_sums();
+        }
+        
+        return get_loan_data().get_nar(sums);
+    }
 
-            // Initialize the worker
-            //
-            td.lcbt->initialize();
+    virtual void collect_invested(const Genome& genome, LoanValueVector& invested)
+    {
+        if (_parallel_mode == ParallelMode::POPULATION) {
+            LCBT::collect_invested(genome, invested);
+            return;
+        }
 
-            // Put the worker in a thread
-            //
-            td.t = new std::thread(ParallelWorkerLCBT::work_function, &td);
+        auto scan = [this, &genome](unsigned worker_idx, unsigned task) {
+            _workers[task]->set_loan_data(_thread_loan_data[worker_idx]);
+            _workers[task]->scan_range(genome);
+        };
+        _pool->run(_num_workers, scan);
+
+        invested.clear();
+        for (auto worker : _workers) {
+            auto& results = worker->get_invested();
+            invested.insert(invested.end(), results.begin(), results.end());
         }
     }
 
-    virtual LoanReturn test(FilterPtrVector& test_filters)
+    virtual void test_batch(Population& population, const std::vector<unsigned>& citizens)
     {
-        _parallel_invested.clear();
+        if (_parallel_mode == ParallelMode::POPULATION) {
+            // One task per work_batch citizens, results are written straight into the population by
+            // whichever pool thread ran the task
+            //
+            const unsigned num_tasks = static_cast<unsigned>((citizens.size() + _work_batch - 1) / _work_batch);
+            auto test = [this, &population, &citizens](unsigned worker_idx, unsigned task) {
+                size_t start = static_cast<size_t>(task) * _work_batch;
+                _workers[worker_idx]->test_citizens(population, citizens, start, std::min(citizens.size(), start + _work_batch));
+            };
+            _pool->run(num_tasks, test);
+            return;
+        }
 
-        // Tell the workers to start processing
-        //
-        for (unsigned i = 0; i < _num_workers; ++i) 
-        {
-            auto& td = *(_threads[i]);
-            {
-                std::unique_lock<std::mutex> l(td.m);
-                td.p = std::promise<bool>();
-                td.f = td.p.get_future();
-                td.test_filters = &test_filters;
-                td.process_loans = true;
+        if (get_batch_size() == 0) {
+            LCBT::test_batch(population, citizens);
+            return;
+        }
+
+        for (size_t start = 0; start < citizens.size(); start += get_batch_size()) {
+            _batch.assign(citizens.begin() + start, citizens.begin() + std::min(citizens.size(), start + get_batch_size()));
+
+            auto scan = [this, &population](unsigned worker_idx, unsigned task) {
+                _workers[task]->set_loan_data(_thread_loan_data[worker_idx]);
+                _workers[task]->scan_batch(population, _batch);
+            };
+            _pool->run(_num_workers, scan);
+
+            for (size_t c = 0; c < _batch.size(); ++c) {
+                LoanReturnSums sums;
+                for (auto worker : _workers) {
+                    sums += worker->get_batch_sums()[c];
+                }
+                population.get_result(_batch[c]) = get_loan_data().get_nar(sums);
             }
-            td.cv.notify_one();
         }
+    }
 
-        // Wait for all workers to finish processing
+    virtual void end_iteration()
+    {
+        // The workers did all the scanning, combine what they saw and hand them back the new order
         //
-        for (unsigned i = 0; i < _num_workers; ++i) {
-            _threads[i]->f.get();
-            // For each worker grab the invested loan information to determine the nar
-            //
-            auto results = _threads[i]->lcbt->get_invested();
-            _parallel_invested.reserve(_parallel_invested.size() + results.size());
-            _parallel_invested.insert(_parallel_invested.end(), results.begin(), results.end());
+        auto& selectivity = get_selectivity();
+        for (auto worker : _workers) {
+            selectivity.merge(worker->get_selectivity());
+            worker->get_selectivity().clear();
+        }
+
+        LCBT::end_iteration();
+
+        for (auto worker : _workers) {
+            worker->get_selectivity().set_order(selectivity.get_order());
         }
-        
-        return get_loan_data().get_nar(_parallel_invested);
     }
 
     virtual void finish()
     {
-        // Send stop signal to all threads and join them...
-        //
-        for (unsigned i = 0; i < _num_workers; ++i)
-        {
-            auto& td = *(_threads[i]);
-            {
-                std::unique_lock<std::mutex> l(td.m);
-                td.stop = true;
+        _pool->stop();
+        _pool->print_stats();
+    }
+
+private:
+    // Picks the loan data every pool thread scans by the "numa" argument and reports which node its
+    // pages are on. Each replica is copied by a thread pinned to the first test thread's cpu on its node.
+    //
+    void place_loan_data(LoanData* loan_data)
+    {
+        const auto& topology = CpuTopology::Get();
+        const auto& thread_cpus = get_thread_cpus();
+
+        std::vector<int> thread_nodes(_num_workers, NumaPlacement::unknown_node);
+        for (unsigned i = 0; i < thread_cpus.size(); ++i) {
+            auto cpu = topology.find(thread_cpus[i]);
+            thread_nodes[i] = (cpu != nullptr) ? cpu->node : NumaPlacement::unknown_node;
+        }
+
+        _thread_loan_data.assign(_num_workers, loan_data);
+        loan_data->info_msg("NUMA placement " + NumaPlacement::get_name(_numa_mode) + ", " +
+            boost::lexical_cast<LCString>(topology.num_nodes()) + " nodes");
+
+        if (_numa_mode == NumaPlacement::Mode::REPLICATE) {
+            if (thread_cpus.empty()) {
+                loan_data->info_msg("The threads are not pinned to nodes, all of them scan the loaded copy");
+            } else if (topology.num_nodes() < 2) {
+                loan_data->info_msg("One node, all the threads scan the loaded copy");
+            } else {
+                std::map<int, LoanData*> node_data;
+                for (unsigned i = 0; i < _num_workers; ++i) {
+                    auto& replica = node_data[thread_nodes[i]];
+                    if (replica == nullptr) {
+                        std::thread copier([&replica, loan_data, &thread_cpus, i]() {
+                            CpuTopology::pin_current_thread(thread_cpus[i]);
+                            replica = loan_data->replicate();
+                        });
+                        copier.join();
+                        _replicas.push_back(std::unique_ptr<LoanData>(replica));
+                    }
+                    _thread_loan_data[i] = replica;
+                }
             }
-            td.cv.notify_one();
-            td.t->join();
         }
+
+        std::map<const LoanData*, std::map<int, size_t>> data_pages;
+        unsigned num_local = 0;
+        for (unsigned i = 0; i < _num_workers; ++i) {
+            const LoanData* data = _thread_loan_data[i];
+            if (data_pages.count(data) == 0) {
+                data_pages[data] = NumaPlacement::count_pages(data->get_memory_regions());
+            }
+
+            const auto& pages = data_pages[data];
+            bool local = (thread_nodes[i] != NumaPlacement::unknown_node) && (pages.size() == 1) && (pages.begin()->first == thread_nodes[i]);
+            num_local += local;
+            LCString thread = "Thread " + boost::lexical_cast<LCString>(i) + ((thread_nodes[i] == NumaPlacement::unknown_node) ?
+                LCString(" is not pinned,") : (" on node " + boost::lexical_cast<LCString>(thread_nodes[i])));
+            loan_data->info_msg(thread + " scans " + ((data == loan_data) ? "the loaded copy" : "a replica") + ", " +
+                NumaPlacement::describe_pages(pages, thread_nodes[i]) +
+                (local ? ", local" : ((thread_nodes[i] == NumaPlacement::unknown_node) ? "" : ", not all local")));
+        }
+        loan_data->info_msg(boost::lexical_cast<LCString>(num_local) + " of " + boost::lexical_cast<LCString>(_num_workers) +
+            " threads scan loan data all on their own node");
     }
 
-private:
     const LoanTypeVector&                   _conversion_filters;
     const unsigned                          _num_workers;
-    LoanValueVector                         _parallel_invested;
-    std::vector<LCBT_ThreadData*>           _threads;
+    const unsigned                          _work_batch;
+    ParallelMode                            _parallel_mode;
+    NumaPlacement::Mode                     _numa_mode;
+    std::unique_ptr<WorkStealingPool>       _pool;
+    std::vector<LoanData*>                  _thread_loan_data;      // the loan data each pool thread scans
+    std::vector<std::unique_ptr<LoanData>>  _replicas;
+    std::vector<unsigned>                   _batch;
+    std::vector<ParallelWorkerLCBT*>        _workers;
 };
 
 };
@@ -20,10 +20,14 @@ Created on July 27, 2014
 #include <fstream>
 #include <iomanip>
 #include <functional>
-#include <map>
+#include <algorithm>
+#include <numeric>
 
 #include "Arguments.hpp"
 #include "LCBT.hpp"
+#include "Genome.hpp"
+#include "FitnessCache.hpp"
+#include "GenomeHashSet.hpp"
 
 namespace lc 
 {
@@ -31,59 +35,55 @@ namespace lc
 class GATest
 {    
 public:
+    // How many times a citizen is re-randomized looking for a filter set never tested before, past that
+    // a duplicate is accepted rather than stalling once most of the search space has been visited
+    static const unsigned max_duplicate_retries = 64;
+
+    // The citizens are genomes over one set of filters, the GA keeps a single filter of each type only
+    // to print the best citizen's values
+    //
     GATest(const LoanTypeVector& backtest_filters, LCBT& lcbt) :
         _lcbt(lcbt),
         _args(LCArguments::Get()),
+        _filters(construct_filters(backtest_filters)),
+        _options(_filters),
+        _even_generation(_options, _args["population_size"].as<unsigned>()),
+        _odd_generation(_options, _args["population_size"].as<unsigned>()),
+        _population(&_even_generation),
+        _next_population(&_odd_generation),
         _iteration(0),
         _iteration_time(0),
-        _best_net_apy(0.0)
+        _mate_time(0),
+        _best_net_apy(0.0),
+        _fitness_cache(_args["fitness_cache_size"].as<unsigned>()),
+        _invested_file_name(_args["invested"].as<LCString>())
     {
-        unsigned population_size = _args["population_size"].as<unsigned>();
-        _population.reserve(population_size);
-        _mate_population.reserve(population_size);
+        const size_t num_genes = _population->num_genes();
         _iterations = _args["iterations"].as<unsigned>();
 
-        std::hash<lc::FilterValue> filter_hash;
-
-        for (unsigned i = 0; i < population_size; ++i) {
-            FilterPtrVector filters(backtest_filters.size());
-            FilterPtrVector mate_filters(backtest_filters.size());
-
-            // Create each of the filters
-            unsigned j = 0;
-            for (auto& filter_type : backtest_filters) {
-                FilterPtrVector::iterator filter_it = filters.begin() + j;
-                construct_filter(filter_type, filter_it);
-                FilterPtrVector::iterator mate_filter_it = mate_filters.begin() + j;
-                construct_filter(filter_type, mate_filter_it);
-                ++j;
-            }
+        for (size_t i = 0; i < _population->size(); ++i) {
+            Gene* genes = _population->get_genes(i);
 
-            unsigned hash_result = 0;
+            GenomeHashSet::Hash hash_result = 0;
+            unsigned retries = 0;
             do {                
-                hash_result = 0;
-
-                for (auto& filter : filters) {
-                    filter->set_current(randint(0, filter->get_count() - 1));
-                    hash_result = hash_result ^ (filter_hash(filter->get_value() << 1));
+                for (size_t k = 0; k < num_genes; ++k) {
+                    genes[k] = static_cast<Gene>(randint(0, _options.get_count(k) - 1));
                 }
+                hash_result = GenomeHashSet::hash(genes, num_genes);
 
             // Keep randomizing until we find a filter set we haven't used before
-            } while (_memoized_filters.find(hash_result) != _memoized_filters.end());
-
-            _population.push_back(std::make_pair(LoanReturn(), filters));
-            _mate_population.push_back(std::make_pair(LoanReturn(), mate_filters));
+            } while (_memoized_filters.contains(hash_result) && (++retries < max_duplicate_retries));
 
-            ++_memoized_filters[hash_result];
+            _memoized_filters.insert(hash_result);
         }
 
-        assert(population_size > 0);
+        assert(_population->size() > 0);
 
         _csv_file.open(_args["csvresults"].as<LCString>().c_str());
 
-        StringVector csv_field_names;
-        for (auto& lc_filter : _population[0].second) {
-            _csv_file << lc_filter->get_name() << ',';
+        for (size_t k = 0; k < num_genes; ++k) {
+            _csv_file << _options.get_name(k) << ',';
         }
 
         _csv_file << "expected_apy,num_loans,num_defaulted,pct_defaulted,avg_default_loss,net_apy\n";
@@ -92,11 +92,13 @@ public:
     void run()
     {
         _iteration_time = _iteration_time.zero();
-        
+        _mate_time = _mate_time.zero();
+
         for (_iteration = 0; _iteration < _iterations; ++_iteration) {
             std::chrono::time_point<std::chrono::system_clock> start = std::chrono::system_clock::now();
 
             calculate_fitness();
+            _lcbt.end_iteration();
             sort_by_fitness();
 
             std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
@@ -104,7 +106,10 @@ public:
             _iteration_time += end - start;
 
             print_best();
+
+            auto mate_start = std::chrono::high_resolution_clock::now();
             mate();
+            _mate_time += std::chrono::high_resolution_clock::now() - mate_start;
         }
 
         _lcbt.finish();
@@ -112,35 +117,64 @@ public:
 
     void calculate_fitness()
     {
-        for (auto& citizen : _population) {
-            citizen.first = _lcbt.test(citizen.second);
+        // Find the citizens that actually need testing
+        //
+        _untested.clear();
+        for (unsigned i = 0; i < _population->size(); ++i) {
+            if (_fitness_cache.enabled()) {
+                FitnessCache::make_key(_population->get_genes(i), _population->num_genes(), _fitness_key);
+                if (_fitness_cache.find(_fitness_key, _population->get_result(i))) {
+                    continue;
+                }
+            }
+            _untested.push_back(i);
+        }
+
+        _lcbt.test_batch(*_population, _untested);
+
+        if (_fitness_cache.enabled()) {
+            for (auto i : _untested) {
+                FitnessCache::make_key(_population->get_genes(i), _population->num_genes(), _fitness_key);
+                _fitness_cache.insert(_fitness_key, _population->get_result(i));
+            }
         }
     }
 
+    // Orders citizens by the results of population, best first
+    //
     struct net_apy_cmp
     {
-        net_apy_cmp(unsigned config_fitness_sort_num_loans) : config_fitness_sort_num_loans(config_fitness_sort_num_loans) {}
+        net_apy_cmp(unsigned config_fitness_sort_num_loans, const Population& population) :
+            config_fitness_sort_num_loans(config_fitness_sort_num_loans), population(population) {}
 
-        inline bool operator() (const std::pair<LoanReturn, FilterPtrVector>& a, const std::pair<LoanReturn, FilterPtrVector>& b)
+        inline bool operator() (const unsigned a_idx, const unsigned b_idx)
         {
-            double a_fit = (a.first.num_loans >= config_fitness_sort_num_loans) ? a.first.net_apy : 0.0;
-            double b_fit = (b.first.num_loans >= config_fitness_sort_num_loans) ? b.first.net_apy : 0.0;
+            const LoanReturn& a = population.get_result(a_idx);
+            const LoanReturn& b = population.get_result(b_idx);
+            double a_fit = (a.num_loans >= config_fitness_sort_num_loans) ? a.net_apy : 0.0;
+            double b_fit = (b.num_loans >= config_fitness_sort_num_loans) ? b.net_apy : 0.0;
             return b_fit < a_fit;
         }
 
         unsigned config_fitness_sort_num_loans;
+        const Population& population;
     };
 
+    // Leaves the citizens where they are and sorts their indices into _order, the best first. The comparisons
+    // are the same as sorting the citizens themselves so equally fit citizens end up in the same order.
+    //
     void sort_by_fitness()
     {
         auto config_fitness_sort_num_loans = _args["fitness_sort_size"].as<unsigned>();
-        std::sort(_population.begin(), _population.end(), net_apy_cmp(config_fitness_sort_num_loans));
+        _order.resize(_population->size());
+        std::iota(_order.begin(), _order.end(), 0);
+        std::sort(_order.begin(), _order.end(), net_apy_cmp(config_fitness_sort_num_loans, *_population));
     }
 
     void print_best()
     {
-        auto& best_results = _population[0].first;
-        auto& best_filters = _population[0].second;
+        auto& best_results = _population->get_result(_order[0]);
+        _population->get_genome(_order[0]).load(_filters);
 
         double expected_apy = 0.0, pct_defaulted = 0.0, net_apy = 0.0, avg_default_loss = 0.0;
         unsigned num_defaulted = 0, loans_per_month = 0;
@@ -155,8 +189,7 @@ public:
 
         if (net_apy > _best_net_apy) {
 
-            for (auto& lc_filter : best_filters) {
-                auto filter_name = lc_filter->get_name();
+            for (auto& lc_filter : _filters) {
                 auto filter_val_str = lc_filter->get_string_value();
                 _csv_file << filter_val_str << ',';
             }
@@ -165,10 +198,14 @@ public:
                << pct_defaulted << ',' << avg_default_loss << ',' << net_apy << '\n';
             std::flush(_csv_file);
             _best_net_apy = net_apy;
+
+            if (!_invested_file_name.empty()) {
+                write_invested(_population->get_genome(_order[0]));
+            }
         }
 
         LCString filters = "";
-        for (auto& lc_filter : best_filters) {
+        for (auto& lc_filter : _filters) {
             auto filter_name = lc_filter->get_name();
             auto filter_val_str = lc_filter->get_string_value();
             filters += filter_name + " is " + filter_val_str + ',';
@@ -176,78 +213,96 @@ public:
 
         std::cout << "Best Filter: " << filters << '\n';
         std::cout << "[iteration " << (_iteration + 1) << '/' << _iterations << ' ' << std::setprecision(4) << _iteration_time.count() / (_iteration + 1);
-        std::cout << " sec/iter] Matched " << best_results.num_loans << '/' << _lcbt.num_loans() << " loans ";
+        std::cout << " sec/iter, " << std::setprecision(4) << _mate_time.count() * 1e6 / std::max(1u, _iteration) << " usec/mate";
+        if (_fitness_cache.enabled()) {
+            std::cout << ", cache " << _fitness_cache.hits() << " hits " << _fitness_cache.misses() << " misses "
+                << _fitness_cache.evictions() << " evictions";
+        }
+        std::cout << "] Matched " << best_results.num_loans << '/' << _lcbt.num_loans() << " loans ";
         std::cout << "(" << loans_per_month << "/mo.) test at " << std::setprecision(4) << expected_apy << "% APY. ";
         std::cout << std::setprecision(4) << num_defaulted << " loans defaulted (" << pct_defaulted << "%, $";
         std::cout << avg_default_loss << " avg loss) " << net_apy << "% net APY\n";
     }
 
-    void copy_population(const PopulationType& from_population, PopulationType& to_population)
+    // The scans only sum up the loans a citizen matches, so the loans themselves are scanned for again here
+    //
+    void write_invested(const Genome& genome)
     {
-        unsigned i = 0;
-        for (auto& lc_pair : from_population) {
-            unsigned j = 0;
-            for (auto& lc_filter : lc_pair.second) {
-                to_population[i].second[j]->set_current(lc_filter->get_current());
-                ++j;
-            }
-            ++i;
+        _lcbt.collect_invested(genome, _invested);
+
+        std::ofstream invested_file(_invested_file_name.c_str());
+        invested_file << "rowid\n";
+        for (auto rowid : _invested) {
+            invested_file << rowid << '\n';
         }
     }
 
+    // Breeds the next generation into the other buffer from the citizens in fitness order, then swaps the
+    // buffers. Citizen i of the next generation is the i-th fittest for the elite, a child otherwise.
+    //
     void mate()
     {
         // Save the elite
-        auto num_elite = boost::numeric_cast<unsigned>(_args["elite_rate"].as<double>() * _population.size());
-        auto mate_size = boost::numeric_cast<unsigned>(std::floor(_population.size() / 5.0));
+        auto num_elite = boost::numeric_cast<unsigned>(_args["elite_rate"].as<double>() * _population->size());
+        auto mate_size = boost::numeric_cast<unsigned>(std::floor(_population->size() / 5.0));
         auto mutation_possibility = boost::numeric_cast<unsigned>(1.0 / _args["mutation_rate"].as<double>());
-        copy_population(_population, _mate_population);
+        const size_t num_genes = _population->num_genes();
 
-        std::hash<lc::FilterValue> filter_hash;
+        for (size_t i = 0; i < num_elite; ++i) {
+            _next_population->copy_citizen(*_population, _order[i], i);
+        }
 
-        for (size_t i = num_elite; i < _population.size(); ++i) {
+        for (size_t i = num_elite; i < _population->size(); ++i) {
 
-            unsigned hash_result = 0;
+            GenomeHashSet::Hash hash_result = 0;
+            unsigned retries = 0;
 
             do {
-                auto& lc_filters = _mate_population[i].second;
-
-                hash_result = 0;
+                Gene* genes = _next_population->get_genes(i);
 
-                for (size_t j = 0, size = lc_filters.size(); j < size; ++j) {
+                for (size_t j = 0; j < num_genes; ++j) {
                     // Mate with 20 % of population
                     auto partner = randint(0, mate_size);
 
-                    lc_filters[j]->set_current(_population[partner].second[j]->get_current());
+                    genes[j] = _population->get_genes(_order[partner])[j];
 
                     // Mutate! Once in a blue moon
                     if (!randint(0, mutation_possibility)) {
-                        auto& lc_filter = lc_filters[j];
-                        lc_filter->set_current(randint(0, lc_filter->get_count() - 1));
+                        genes[j] = static_cast<Gene>(randint(0, _options.get_count(j) - 1));
                     }
-
-                    hash_result = hash_result ^ (filter_hash(lc_filters[j]->get_value()) << 1);
                 }
+                hash_result = GenomeHashSet::hash(genes, num_genes);
+
             // Keep randomizing until we find a filter set we haven't used before
-            } while (_memoized_filters.find(hash_result) != _memoized_filters.end());
+            } while (_memoized_filters.contains(hash_result) && (++retries < max_duplicate_retries));
 
-            ++_memoized_filters[hash_result];
+            _memoized_filters.insert(hash_result);
         }
 
-        copy_population(_mate_population, _population);
+        std::swap(_population, _next_population);
     }
 
     LCBT&                                                       _lcbt;
     const Arguments&                                            _args;
     FilterPtrVector                                             _filters;
-    PopulationType                                              _population;
-    PopulationType                                              _mate_population;
+    FilterOptionTable                                           _options;
+    Population                                                  _even_generation;
+    Population                                                  _odd_generation;
+    Population*                                                 _population;            // the generation being tested
+    Population*                                                 _next_population;       // where mate() breeds the next one
     unsigned                                                    _iteration;
     unsigned                                                    _iterations;
     std::chrono::duration<double>                               _iteration_time;
+    std::chrono::duration<double>                               _mate_time;
     std::ofstream                                               _csv_file;
     double                                                      _best_net_apy;
-    std::map<unsigned, unsigned>                                _memoized_filters;
+    GenomeHashSet                                               _memoized_filters;
+    FitnessCache                                                _fitness_cache;
+    FitnessCache::Key                                           _fitness_key;
+    std::vector<unsigned>                                       _untested;
+    std::vector<unsigned>                                       _order;                 // citizens of _population, the fittest first
+    LCString                                                    _invested_file_name;
+    LoanValueVector                                             _invested;
 };
 
 };
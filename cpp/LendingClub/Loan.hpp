@@ -13,6 +13,7 @@ Created on July 28, 2014
 #ifndef __LC_LOAN_HPP__
 #define __LC_LOAN_HPP__
 
+#include <cassert>
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include "Types.hpp"
 
@@ -79,6 +80,14 @@ struct Loan
     LoanValue                       addr_state;
     LoanValue                       total_acc;
     LoanValue                       desc_word_count;
+
+    // Returns the back-testing value for the given type, relies on the members above
+    // being laid out in LoanType order
+    inline LoanValue get(const LoanType loan_value_type) const
+    {
+        assert(loan_value_type <= DESC_WORD_COUNT);
+        return (&rowid)[loan_value_type];
+    }
 };
 
 typedef std::vector<Loan::LoanType> LoanTypeVector;
@@ -111,6 +120,34 @@ struct LoanReturn
     double                          net_apy;
 };
 
+// Running sums a LoanReturn is computed from, each worker sums its own loans and only these are
+// added up across workers
+//
+struct LoanReturnSums
+{
+    LoanReturnSums() : num_loans(0), defaulted(0), per_month(0), profit(0.0), principal(0.0), lost(0.0), rate(0.0) {}
+
+    LoanReturnSums& operator+=(const LoanReturnSums& other)
+    {
+        num_loans += other.num_loans;
+        defaulted += other.defaulted;
+        per_month += other.per_month;
+        profit += other.profit;
+        principal += other.principal;
+        lost += other.lost;
+        rate += other.rate;
+        return *this;
+    }
+
+    size_t                          num_loans;
+    unsigned                        defaulted;
+    unsigned                        per_month;
+    double                          profit;
+    double                          principal;
+    double                          lost;
+    double                          rate;
+};
+
 };
 
 #endif // __LC_LOAN_HPP__
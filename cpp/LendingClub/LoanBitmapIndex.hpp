@@ -0,0 +1,213 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_LOAN_BITMAP_INDEX_HPP__
+#define __LC_LOAN_BITMAP_INDEX_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "Types.hpp"
+#include "Loan.hpp"
+#include "Filter.hpp"
+#include "Genome.hpp"
+#include "Utilities.hpp"
+
+namespace lc
+{
+
+//
+// For every filter and every one of its options this holds a packed bitset of the loan rows
+// the filter matches, so a set of filters is tested by AND-ing bitsets instead of looking at
+// the loan data.
+//
+// MASK filters (CreditGrade, State, LoanPurpose, ...) use power sets for their options, which
+// would be far too many bitsets (LoanPurpose alone has 16384 options), so for those we keep one
+// bitset per bit used by the options and OR the ones set in the current option.
+//
+class LoanBitmapIndex
+{
+public:
+    typedef std::uint64_t Word;
+    typedef std::vector<Word> WordVector;
+    typedef std::vector<Word, HugePageAllocator<Word>> WordArena;
+
+    static const unsigned bits_per_word = 64;
+
+    LoanBitmapIndex() : _num_loans(0), _num_words(0) {}
+
+    static unsigned words_for(const unsigned num_loans)
+    {
+        return (num_loans + bits_per_word - 1) / bits_per_word;
+    }
+
+    void build(const LoanVector& loans, const LoanTypeVector& conversion_filters, const FilterPtrVector& filters)
+    {
+        _num_loans = loans.size();
+        _num_words = words_for(_num_loans);
+        _columns.clear();
+        _columns.resize(conversion_filters.size());
+
+        // All the bitsets are in one block, MASK filters have one per bit used by any option
+        //
+        size_t num_bitmaps = 0;
+        for (auto loan_value_type : conversion_filters) {
+            auto filter = filters[loan_value_type];
+            const FilterValueVector& options = filter->get_options();
+            if (filter->get_relation() != Filter::Relation::MASK) {
+                num_bitmaps += options.size();
+            } else {
+                FilterValue used_bits = 0;
+                for (auto option : options) {
+                    used_bits |= option;
+                }
+                num_bitmaps += population_count(used_bits);
+            }
+        }
+        _words.assign(num_bitmaps * _num_words, 0);
+        size_t next_bitmap = 0;
+
+        for (size_t k = 0; k < conversion_filters.size(); ++k) {
+            auto loan_value_type = conversion_filters[k];
+            auto filter = filters[loan_value_type];
+            auto& column = _columns[k];
+            const FilterValueVector& options = filter->get_options();
+
+            column.relation = filter->get_relation();
+
+            if (column.relation != Filter::Relation::MASK) {
+                for (size_t i = 0; i < options.size(); ++i) {
+                    column.bitmaps.push_back(next_bitmap++ * _num_words);
+                    build_bitmap(loans, loan_value_type, column.relation, options[i], &_words[column.bitmaps.back()]);
+                }
+            } else {
+                // Find all the bits used by any of the options, each becomes one bitset
+                //
+                FilterValue used_bits = 0;
+                for (auto option : options) {
+                    used_bits |= option;
+                }
+
+                std::vector<unsigned> bitmap_of_bit(sizeof(FilterValue) * 8, 0);
+                for (unsigned bit = 0; bit < sizeof(FilterValue) * 8; ++bit) {
+                    FilterValue bit_value = 1ull << bit;
+                    if (used_bits & bit_value) {
+                        bitmap_of_bit[bit] = column.bitmaps.size();
+                        column.bitmaps.push_back(next_bitmap++ * _num_words);
+                        build_bitmap(loans, loan_value_type, column.relation, bit_value, &_words[column.bitmaps.back()]);
+                    }
+                }
+
+                column.option_bitmaps.resize(options.size());
+                for (size_t i = 0; i < options.size(); ++i) {
+                    for (FilterValue bits = options[i]; bits != 0; bits &= bits - 1) {
+                        column.option_bitmaps[i].push_back(bitmap_of_bit[count_trailing_zeros(bits)]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Writes the words [first_word, last_word) of the set of loans matching all the filters into result,
+    // the filters are applied in the given order, returns false when no loan in the range matched
+    //
+    bool select(const Genome& genome, const std::vector<unsigned>& order, const unsigned first_word,
+        const unsigned last_word, Word* result) const
+    {
+        assert(genome.size() == _columns.size());
+        assert(last_word <= _num_words);
+
+        const unsigned num_words = last_word - first_word;
+        std::fill(result, result + num_words, ~Word(0));
+
+        for (auto k : order) {
+            const auto& column = _columns[k];
+            const unsigned current = genome.get_current(k);
+            Word any = 0;
+
+            if (column.relation != Filter::Relation::MASK) {
+                const Word* bitmap = &(_words[column.bitmaps[current] + first_word]);
+                for (unsigned i = 0; i < num_words; ++i) {
+                    result[i] &= bitmap[i];
+                    any |= result[i];
+                }
+            } else {
+                const auto& option_bitmaps = column.option_bitmaps[current];
+                for (unsigned i = 0; i < num_words; ++i) {
+                    Word bits = 0;
+                    for (auto bitmap_idx : option_bitmaps) {
+                        bits |= _words[column.bitmaps[bitmap_idx] + first_word + i];
+                    }
+                    result[i] &= bits;
+                    any |= result[i];
+                }
+            }
+
+            if (any == 0) {
+                std::fill(result, result + num_words, Word(0));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    unsigned num_words() const
+    {
+        return _num_words;
+    }
+
+    unsigned num_bitmaps() const
+    {
+        unsigned count = 0;
+        for (auto& column : _columns) {
+            count += column.bitmaps.size();
+        }
+        return count;
+    }
+
+    size_t size_in_bytes() const
+    {
+        return static_cast<size_t>(num_bitmaps()) * _num_words * sizeof(Word);
+    }
+
+    void add_memory_regions(MemoryRegions& regions) const
+    {
+        regions.push_back(std::make_pair(static_cast<const void*>(_words.data()), _words.size() * sizeof(Word)));
+    }
+
+private:
+    struct Column
+    {
+        Filter::Relation                        relation;
+        std::vector<size_t>                     bitmaps;            // start in _words per option, or per bit for MASK relations
+        std::vector<std::vector<unsigned>>      option_bitmaps;     // MASK only, the per bit bitmaps making up each option
+    };
+
+    void build_bitmap(const LoanVector& loans, const Loan::LoanType loan_value_type, const Filter::Relation relation,
+        const FilterValue value, Word* bitmap) const
+    {
+        for (unsigned i = 0; i < _num_loans; ++i) {
+            if (Filter::compare(relation, loans[i].get(loan_value_type), value)) {
+                bitmap[i / bits_per_word] |= Word(1) << (i % bits_per_word);
+            }
+        }
+    }
+
+    unsigned                                    _num_loans;
+    unsigned                                    _num_words;
+    std::vector<Column>                         _columns;
+    WordArena                                   _words;
+};
+
+};
+
+#endif // __LC_LOAN_BITMAP_INDEX_HPP__
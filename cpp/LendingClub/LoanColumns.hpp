@@ -0,0 +1,328 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_LOAN_COLUMNS_HPP__
+#define __LC_LOAN_COLUMNS_HPP__
+
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include "Types.hpp"
+#include "Loan.hpp"
+#include "Filter.hpp"
+#include "HugePages.hpp"
+
+namespace lc
+{
+
+//
+// A single loan column stored in the narrowest unsigned integer type which holds all its values,
+// the width is picked when the column is built.
+//
+// The width is a runtime tag rather than a type fixed per Loan::LoanType at compile time because it
+// depends on the stats file, not on the field: the largest funded amount, income or credit line date
+// differs from one file to the next and a width picked for the field would either waste bytes or
+// overflow. The tag is switched on once per column per scan call, the kernels under it are templates
+// instantiated for each width, so no row is ever evaluated through the switch.
+//
+class LoanColumn
+{
+public:
+    enum class Width : std::int8_t { U8 = 1, U16 = 2, U32 = 4, U64 = 8 };
+
+    template<typename T> struct WidthOf;
+
+    LoanColumn() : _width(Width::U64), _num_loans(0) {}
+
+    void build(const LoanVector& loans, const Loan::LoanType loan_value_type)
+    {
+        _num_loans = loans.size();
+
+        LoanValue max_value = 0;
+        for (auto& loan : loans) {
+            max_value = std::max(max_value, loan.get(loan_value_type));
+        }
+
+        if (max_value <= std::numeric_limits<std::uint8_t>::max()) {
+            fill<std::uint8_t>(loans, loan_value_type);
+        } else if (max_value <= std::numeric_limits<std::uint16_t>::max()) {
+            fill<std::uint16_t>(loans, loan_value_type);
+        } else if (max_value <= std::numeric_limits<std::uint32_t>::max()) {
+            fill<std::uint32_t>(loans, loan_value_type);
+        } else {
+            fill<std::uint64_t>(loans, loan_value_type);
+        }
+    }
+
+    template<typename T>
+    inline const T* data() const
+    {
+        assert(WidthOf<T>::value == _width);
+        return reinterpret_cast<const T*>(_data.data());
+    }
+
+    inline Width width() const
+    {
+        return _width;
+    }
+
+    inline LoanValue get(const unsigned idx) const
+    {
+        switch (_width) {
+        case Width::U8:  return data<std::uint8_t>()[idx];
+        case Width::U16: return data<std::uint16_t>()[idx];
+        case Width::U32: return data<std::uint32_t>()[idx];
+        case Width::U64: return data<std::uint64_t>()[idx];
+        }
+        return 0;
+    }
+
+    size_t size_in_bytes() const
+    {
+        return static_cast<size_t>(_num_loans) * static_cast<size_t>(_width);
+    }
+
+    void add_memory_regions(MemoryRegions& regions) const
+    {
+        regions.push_back(std::make_pair(static_cast<const void*>(_data.data()), _data.size()));
+    }
+
+private:
+    template<typename T>
+    void fill(const LoanVector& loans, const Loan::LoanType loan_value_type)
+    {
+        // Pad the column to a whole number of 64 loan words so vectorized kernels never read past the end
+        //
+        const unsigned padded_loans = (_num_loans + 63) / 64 * 64;
+        _width = WidthOf<T>::value;
+        _data.assign(padded_loans * sizeof(T), 0);
+        T* column = reinterpret_cast<T*>(_data.data());
+        for (unsigned i = 0; i < _num_loans; ++i) {
+            column[i] = static_cast<T>(loans[i].get(loan_value_type));
+        }
+    }
+
+    Width                                                       _width;
+    unsigned                                                    _num_loans;
+    std::vector<std::uint8_t, HugePageAllocator<std::uint8_t>>  _data;
+};
+
+template<> struct LoanColumn::WidthOf<std::uint8_t>  { static const Width value = Width::U8; };
+template<> struct LoanColumn::WidthOf<std::uint16_t> { static const Width value = Width::U16; };
+template<> struct LoanColumn::WidthOf<std::uint32_t> { static const Width value = Width::U32; };
+template<> struct LoanColumn::WidthOf<std::uint64_t> { static const Width value = Width::U64; };
+
+//
+// Structure of arrays copy of the LoanVector, one contiguous cache line aligned array per
+// Loan::LoanType, so scanning a single filter only touches the values it needs
+//
+class LoanColumns
+{
+public:
+    static const unsigned num_columns = Loan::DESC_WORD_COUNT + 1;
+
+    LoanColumns() : _num_loans(0), _columns(num_columns) {}
+
+    void build(const LoanVector& loans)
+    {
+        _num_loans = loans.size();
+        for (unsigned type = 0; type < num_columns; ++type) {
+            _columns[type].build(loans, static_cast<Loan::LoanType>(type));
+        }
+    }
+
+    inline const LoanColumn& get(const Loan::LoanType loan_value_type) const
+    {
+        assert(loan_value_type < num_columns);
+        return _columns[loan_value_type];
+    }
+
+    unsigned num_loans() const
+    {
+        return _num_loans;
+    }
+
+    // Size the columns would take as plain LoanValues
+    size_t unpacked_size_in_bytes() const
+    {
+        return static_cast<size_t>(num_columns) * _num_loans * sizeof(LoanValue);
+    }
+
+    size_t size_in_bytes() const
+    {
+        size_t size = 0;
+        for (auto& column : _columns) {
+            size += column.size_in_bytes();
+        }
+        return size;
+    }
+
+    void add_memory_regions(MemoryRegions& regions) const
+    {
+        for (auto& column : _columns) {
+            column.add_memory_regions(regions);
+        }
+    }
+
+private:
+    unsigned                                    _num_loans;
+    std::vector<LoanColumn>                     _columns;
+};
+
+//
+// Column at a time filter kernels. Each kernel evaluates one relation over one column and writes the
+// matching row ids into a selection vector without branching on the result. The kernels are
+// instantiated for every column width, the filter value is narrowed to the column width first.
+//
+struct ColumnScan
+{
+    struct LessThanEqual    { template<typename T> static inline bool apply(const T a, const T b) { return a <= b; } };
+    struct LessThan         { template<typename T> static inline bool apply(const T a, const T b) { return a <  b; } };
+    struct GreaterThan      { template<typename T> static inline bool apply(const T a, const T b) { return a >  b; } };
+    struct GreaterThanEqual { template<typename T> static inline bool apply(const T a, const T b) { return a >= b; } };
+    struct Mask             { template<typename T> static inline bool apply(const T a, const T b) { return (a & b) != 0; } };
+    struct Equal            { template<typename T> static inline bool apply(const T a, const T b) { return a == b; } };
+    struct NotEqual         { template<typename T> static inline bool apply(const T a, const T b) { return a != b; } };
+
+    // What a relation does when the filter value does not fit in the column
+    enum class Narrowed : std::int8_t { COMPARE = 0, ALL = 1, NONE = 2 };
+
+    template<typename T>
+    static Narrowed narrow(const Filter::Relation relation, FilterValue& value)
+    {
+        const FilterValue max_value = std::numeric_limits<T>::max();
+        if (value <= max_value) {
+            return Narrowed::COMPARE;
+        }
+
+        switch (relation) {
+        case Filter::Relation::MASK:
+            // All the column values fit in T so the upper bits can never match
+            value &= max_value;
+            return Narrowed::COMPARE;
+        case Filter::Relation::LESS_THAN_EQUAL:
+        case Filter::Relation::LESS_THAN:
+        case Filter::Relation::NOT_EQUAL:
+            return Narrowed::ALL;
+        default:
+            return Narrowed::NONE;
+        }
+    }
+
+    // Selects the rows in [start, end) of the column matching the filter value
+    //
+    template<typename Op, typename T>
+    static unsigned select(const T* column, const unsigned start, const unsigned end, const T value, unsigned* selection)
+    {
+        unsigned n = 0;
+        for (unsigned i = start; i < end; ++i) {
+            selection[n] = i;
+            n += Op::apply(column[i], value);
+        }
+        return n;
+    }
+
+    // Narrows down an existing selection to the rows of the column matching the filter value
+    //
+    template<typename Op, typename T>
+    static unsigned refine(const T* column, const unsigned num_selected, const T value, unsigned* selection)
+    {
+        unsigned n = 0;
+        for (unsigned j = 0; j < num_selected; ++j) {
+            unsigned i = selection[j];
+            selection[n] = i;
+            n += Op::apply(column[i], value);
+        }
+        return n;
+    }
+
+    template<typename T>
+    static unsigned select(const Filter::Relation relation, const T* column, const unsigned start, const unsigned end,
+        FilterValue value, unsigned* selection)
+    {
+        switch (narrow<T>(relation, value)) {
+        case Narrowed::ALL:
+            for (unsigned i = start; i < end; ++i) {
+                selection[i - start] = i;
+            }
+            return end - start;
+        case Narrowed::NONE:
+            return 0;
+        case Narrowed::COMPARE:
+            break;
+        }
+
+        const T v = static_cast<T>(value);
+        switch (relation) {
+        case Filter::Relation::LESS_THAN_EQUAL:    return select<LessThanEqual>(column, start, end, v, selection);
+        case Filter::Relation::LESS_THAN:          return select<LessThan>(column, start, end, v, selection);
+        case Filter::Relation::GREATER_THAN:       return select<GreaterThan>(column, start, end, v, selection);
+        case Filter::Relation::GREATER_THAN_EQUAL: return select<GreaterThanEqual>(column, start, end, v, selection);
+        case Filter::Relation::MASK:               return select<Mask>(column, start, end, v, selection);
+        case Filter::Relation::EQUAL:              return select<Equal>(column, start, end, v, selection);
+        case Filter::Relation::NOT_EQUAL:          return select<NotEqual>(column, start, end, v, selection);
+        }
+        return 0;
+    }
+
+    template<typename T>
+    static unsigned refine(const Filter::Relation relation, const T* column, const unsigned num_selected,
+        FilterValue value, unsigned* selection)
+    {
+        switch (narrow<T>(relation, value)) {
+        case Narrowed::ALL:     return num_selected;
+        case Narrowed::NONE:    return 0;
+        case Narrowed::COMPARE: break;
+        }
+
+        const T v = static_cast<T>(value);
+        switch (relation) {
+        case Filter::Relation::LESS_THAN_EQUAL:    return refine<LessThanEqual>(column, num_selected, v, selection);
+        case Filter::Relation::LESS_THAN:          return refine<LessThan>(column, num_selected, v, selection);
+        case Filter::Relation::GREATER_THAN:       return refine<GreaterThan>(column, num_selected, v, selection);
+        case Filter::Relation::GREATER_THAN_EQUAL: return refine<GreaterThanEqual>(column, num_selected, v, selection);
+        case Filter::Relation::MASK:               return refine<Mask>(column, num_selected, v, selection);
+        case Filter::Relation::EQUAL:              return refine<Equal>(column, num_selected, v, selection);
+        case Filter::Relation::NOT_EQUAL:          return refine<NotEqual>(column, num_selected, v, selection);
+        }
+        return 0;
+    }
+
+    static unsigned select(const Filter::Relation relation, const LoanColumn& column, const unsigned start, const unsigned end,
+        const FilterValue value, unsigned* selection)
+    {
+        switch (column.width()) {
+        case LoanColumn::Width::U8:  return select(relation, column.data<std::uint8_t>(), start, end, value, selection);
+        case LoanColumn::Width::U16: return select(relation, column.data<std::uint16_t>(), start, end, value, selection);
+        case LoanColumn::Width::U32: return select(relation, column.data<std::uint32_t>(), start, end, value, selection);
+        case LoanColumn::Width::U64: return select(relation, column.data<std::uint64_t>(), start, end, value, selection);
+        }
+        return 0;
+    }
+
+    static unsigned refine(const Filter::Relation relation, const LoanColumn& column, const unsigned num_selected,
+        const FilterValue value, unsigned* selection)
+    {
+        switch (column.width()) {
+        case LoanColumn::Width::U8:  return refine(relation, column.data<std::uint8_t>(), num_selected, value, selection);
+        case LoanColumn::Width::U16: return refine(relation, column.data<std::uint16_t>(), num_selected, value, selection);
+        case LoanColumn::Width::U32: return refine(relation, column.data<std::uint32_t>(), num_selected, value, selection);
+        case LoanColumn::Width::U64: return refine(relation, column.data<std::uint64_t>(), num_selected, value, selection);
+        }
+        return 0;
+    }
+};
+
+};
+
+#endif // __LC_LOAN_COLUMNS_HPP__
@@ -18,15 +18,29 @@ Created on July 28, 2014
 #include <vector>
 #include <string>
 #include <map>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <unordered_set>
 #include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast/try_lexical_convert.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
+#include "Amortization.hpp"
 #include "Arguments.hpp"
 #include "Types.hpp"
 #include "Loan.hpp"
 #include "Filters.hpp"
-#include "csv.h"
+#include "LoanBitmapIndex.hpp"
+#include "LoanColumns.hpp"
+#include "LoanMetrics.hpp"
+#include "LoanSnapshot.hpp"
+#include "MappedCSVReader.hpp"
+#include "FieldParsers.hpp"
+#include "WorkStealingPool.hpp"
 
 namespace lc
 {
@@ -38,6 +52,7 @@ public:
         const LoanTypeVector& conversion_filters,
         const int worker_idx) : 
             _args(LCArguments::Get()),
+            _conversion_filters(conversion_filters),
             _filters(conversion_filters.size()),
             _worker_idx(worker_idx),
             _row(0),
@@ -47,6 +62,7 @@ public:
     { 
         _loans.reserve(350000);
         _loan_infos.reserve(350000);
+        _metrics.reserve(350000);
         
         // Create each of the filters and use its conversion utility for normalizing the data
         //
@@ -69,193 +85,537 @@ public:
 
     virtual void mid_stage_initialization() {}
 
+    // The fields of a stats row, they point into the mapped stats file and are laid out in the order
+    // of columns() so read_row can fill them in as an array
+    //
     struct RawLoan
     {
-        LCString acc_open_past_24mths;
-        LCString funded_amnt;
-        LCString annual_inc;
-        LCString grade;
-        LCString dti;
-        LCString delinq_2yrs;
-        LCString earliest_cr_line;
-        LCString emp_length;
-        LCString home_ownership;
-        LCString is_inc_v;
-        LCString inq_last_6mths;
-        LCString purpose;
-        LCString mths_since_last_delinq;
-        LCString pub_rec;
-        LCString revol_util;
-        LCString addr_state;
-        LCString total_acc;
-        LCString desc;
-        LCString loan_status;
-        LCString issue_d;
-        LCString term;
-        LCString installment;
-        LCString int_rate;
-        LCString total_pymnt;
-        LCString out_prncp;
-        LCString out_prncp_inv;
-        LCString total_rec_int;
-        LCString total_rec_prncp;        
+        LCStringRef acc_open_past_24mths;
+        LCStringRef funded_amnt;
+        LCStringRef annual_inc;
+        LCStringRef grade;
+        LCStringRef dti;
+        LCStringRef delinq_2yrs;
+        LCStringRef earliest_cr_line;
+        LCStringRef emp_length;
+        LCStringRef home_ownership;
+        LCStringRef is_inc_v;
+        LCStringRef inq_last_6mths;
+        LCStringRef purpose;
+        LCStringRef mths_since_last_delinq;
+        LCStringRef pub_rec;
+        LCStringRef revol_util;
+        LCStringRef addr_state;
+        LCStringRef total_acc;
+        LCStringRef desc;
+        LCStringRef loan_status;
+        LCStringRef issue_d;
+        LCStringRef term;
+        LCStringRef installment;
+        LCStringRef int_rate;
+        LCStringRef total_pymnt;
+        LCStringRef out_prncp;
+        LCStringRef out_prncp_inv;
+        LCStringRef total_rec_int;
+        LCStringRef total_rec_prncp;
+        LCStringRef id;                         // the same loan may be listed in several stats files
+
+        LCStringRef* fields()
+        {
+            return &acc_open_past_24mths;
+        }
+
+        // The field a filter converts, the fields up to desc are in LoanType order
+        const LCStringRef& get(const Loan::LoanType loan_value_type) const
+        {
+            assert((loan_value_type > Loan::ROWID) && (loan_value_type <= Loan::DESC_WORD_COUNT));
+            return (&acc_open_past_24mths)[loan_value_type - 1];
+        }
+
+        static const StringVector& columns()
+        {
+            static const StringVector names = { "acc_open_past_24mths", "funded_amnt", "annual_inc", "grade",
+                "dti", "delinq_2yrs", "earliest_cr_line", "emp_length", "home_ownership", "is_inc_v", "inq_last_6mths",
+                "purpose", "mths_since_last_delinq", "pub_rec", "revol_util", "addr_state", "total_acc", "desc",
+                "loan_status", "issue_d", "term", "installment", "int_rate", "total_pymnt", "out_prncp", "out_prncp_inv",
+                "total_rec_int", "total_rec_prncp", "id" };
+            return names;
+        }
+
         LCString to_str() const 
         {
             LCString str;
-            str += "acc_open_past_24mths=" + acc_open_past_24mths + ',';
-            str += "funded_amnt=" + funded_amnt + ',';
-            str += "annual_inc=" + annual_inc + ',';
-            str += "grade=" + grade + ',';
-            str += "dti=" + dti + ',';
-            str += "delinq_2yrs=" + delinq_2yrs + ',';
-            str += "earliest_cr_line=" + earliest_cr_line + ',';
-            str += "home_ownership=" + home_ownership + ',';
-            str += "is_inc_v=" + is_inc_v + ',';
-            str += "inq_last_6mths=" + inq_last_6mths + ',';
-            str += "purpose=" + purpose + ',';
-            str += "mths_since_last_delinq=" + mths_since_last_delinq + ',';
-            str += "pub_rec=" + pub_rec +',';
-            str += "revol_util=" + revol_util + ',';
-            str += "addr_state=" + addr_state + ',';
-            str += "total_acc=" + total_acc + ',';
-            str += "desc=" + desc + ',';
-            str += "loan_status=" + loan_status + ',';
-            str += "issue_d=" + issue_d + ',';
-            str += "term=" + term + ',';
-            str += "installment=" + installment + ',';
-            str += "int_rate=" + int_rate + ',';
-            str += "total_pymnt=" + total_pymnt + ',';
-            str += "out_prncp=" + out_prncp + ',';
-            str += "out_prncp_inv=" + out_prncp_inv + ',';
-            str += "total_rec_int=" + total_rec_int + ',';
-            str += "total_rec_prncp=" + total_rec_prncp;
+            str += "acc_open_past_24mths=" + acc_open_past_24mths.to_string() + ',';
+            str += "funded_amnt=" + funded_amnt.to_string() + ',';
+            str += "annual_inc=" + annual_inc.to_string() + ',';
+            str += "grade=" + grade.to_string() + ',';
+            str += "dti=" + dti.to_string() + ',';
+            str += "delinq_2yrs=" + delinq_2yrs.to_string() + ',';
+            str += "earliest_cr_line=" + earliest_cr_line.to_string() + ',';
+            str += "home_ownership=" + home_ownership.to_string() + ',';
+            str += "is_inc_v=" + is_inc_v.to_string() + ',';
+            str += "inq_last_6mths=" + inq_last_6mths.to_string() + ',';
+            str += "purpose=" + purpose.to_string() + ',';
+            str += "mths_since_last_delinq=" + mths_since_last_delinq.to_string() + ',';
+            str += "pub_rec=" + pub_rec.to_string() +',';
+            str += "revol_util=" + revol_util.to_string() + ',';
+            str += "addr_state=" + addr_state.to_string() + ',';
+            str += "total_acc=" + total_acc.to_string() + ',';
+            str += "desc=" + desc.to_string() + ',';
+            str += "loan_status=" + loan_status.to_string() + ',';
+            str += "issue_d=" + issue_d.to_string() + ',';
+            str += "term=" + term.to_string() + ',';
+            str += "installment=" + installment.to_string() + ',';
+            str += "int_rate=" + int_rate.to_string() + ',';
+            str += "total_pymnt=" + total_pymnt.to_string() + ',';
+            str += "out_prncp=" + out_prncp.to_string() + ',';
+            str += "out_prncp_inv=" + out_prncp_inv.to_string() + ',';
+            str += "total_rec_int=" + total_rec_int.to_string() + ',';
+            str += "total_rec_prncp=" + total_rec_prncp.to_string() + ',';
+            str += "id=" + id.to_string();
             return str;
         }
     };
 
     virtual void initialize() 
     {
-        boost::filesystem::path stats_file_path = _args["stats"].as<LCString>();
-        if (boost::filesystem::exists(stats_file_path)) {
-            info_msg("Initializing from " + stats_file_path.string());
-            
-            io::CSVReader<28, io::trim_chars<' ', '\t'>, io::double_quote_escape<',', '\"'>, io::throw_on_overflow, io::single_line_comment<'N','L','\0'> > in(stats_file_path.string().c_str());
-            in.read_header(io::ignore_extra_column, "acc_open_past_24mths", "funded_amnt", "annual_inc", "grade", 
-                "dti", "delinq_2yrs", "earliest_cr_line", "emp_length", "home_ownership", "is_inc_v", "inq_last_6mths",
-                "purpose", "mths_since_last_delinq", "pub_rec", "revol_util", "addr_state", "total_acc", "desc",
-                "loan_status", "issue_d", "term", "installment", "int_rate", "total_pymnt", "out_prncp", "out_prncp_inv",
-                "total_rec_int", "total_rec_prncp");
+        StringVector stats_files = expand_paths(_args["stats"].as<LCString>());
+        if (stats_files.empty()) {
+            info_msg("error: no stats files given");
+            exit(-1);
+        }
+
+        for (const auto& stats_file : stats_files) {
+            if (!boost::filesystem::exists(stats_file)) {
+                info_msg("error: " + stats_file + " not found");
+                exit(-1);
+            }
+        }
+
+        if (!load_snapshot(stats_files)) {
+            parse_stats(stats_files);
+            save_snapshot(stats_files);
+        }
 
+        // Checks the loans however they were loaded, the parallel parse or the snapshot
+        //
+        if (_args["verify_load"].as<bool>()) {
+            verify_load(stats_files);
+        }
+        info_averages();
+
+        _columns.build(_loans);
+        info_columns();
+
+        _bitmap_index.build(_loans, _conversion_filters, _filters);
+        info_msg("Bitmap index " + boost::lexical_cast<LCString>(_bitmap_index.num_bitmaps()) + " bitmaps of " +
+            boost::lexical_cast<LCString>(_bitmap_index.num_words()) + " words, " +
+            boost::lexical_cast<LCString>(_bitmap_index.size_in_bytes() / (1024 * 1024)) + " MB");
+        info_msg("Loan metrics " + boost::lexical_cast<LCString>(_metrics.size_in_bytes()) + " bytes");
+        info_msg(HugePages::Get().describe(get_memory_regions()));
+    }
+
+    // Loans without a numeric id are never taken for duplicates
+    static const LoanValue no_loan_id = ~LoanValue(0);
+
+    // The loans parsed from one range of a stats file, in file order, and the diagnostics of its rows, kept
+    // for after the load threads are done so lines of different threads are never printed into each other
+    //
+    struct LoanChunk
+    {
+        LoanChunk() : file_idx(0), counts(LoanSnapshot::Counts()), num_rows(0) {}
+
+        unsigned                            file_idx;
+        LoanValueVector                     ids;
+        LoanVector                          loans;
+        LoanInfoVector                      loan_infos;
+        std::vector<LoanMetric>             metrics;
+        LoanSnapshot::Counts                counts;
+        size_t                              num_rows;
+        StringVector                        messages;
+        std::exception_ptr                  error;
+    };
+
+    // What happened to the rows of one stats file
+    //
+    struct FileCounts
+    {
+        FileCounts() : num_rows(0), num_loans(0), duplicates(0), counts(LoanSnapshot::Counts()) {}
+
+        size_t                              num_rows;
+        size_t                              num_loans;
+        size_t                              duplicates;         // loans with an id an earlier row already had
+        LoanSnapshot::Counts                counts;
+    };
+
+    // Ranges per load thread, a range of slow rows is made up for by the other threads stealing the rest
+    static const unsigned ranges_per_load_thread = 8;
+
+    // How far --verify_load lets the closed form amortization be from the monthly loop
+    static constexpr double max_amortization_error = 1e-9;
+
+    void parse_stats(const StringVector& stats_files)
+    {
+        static_assert(sizeof(RawLoan) == 29 * sizeof(LCStringRef), "RawLoan must only hold its fields");
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::unique_ptr<MappedCSVReader>> readers;
+        size_t num_bytes = 0;
+        for (const auto& stats_file : stats_files) {
+            info_msg("Initializing from " + stats_file);
+            readers.push_back(std::unique_ptr<MappedCSVReader>(new MappedCSVReader(stats_file)));
+            readers.back()->read_header(RawLoan::columns());
+            num_bytes += readers.back()->get_size();
+        }
+
+        // The rows of all the files are split into ranges parsed and normalized concurrently, each file
+        // gets ranges in proportion to its size. The ranges are appended in order so the rowids are the
+        // same as with a single thread.
+        //
+        const unsigned num_threads = std::max(1u, _args["workers"].as<unsigned>());
+        const size_t num_ranges = num_threads * ranges_per_load_thread;
+        std::vector<MappedCSVReader::Range> ranges;
+        std::vector<LoanChunk> chunks;
+        for (unsigned file_idx = 0; file_idx < readers.size(); ++file_idx) {
+            auto file_ranges = readers[file_idx]->split(static_cast<unsigned>(
+                std::max<size_t>(1, num_ranges * readers[file_idx]->get_size() / std::max<size_t>(1, num_bytes))));
+            for (const auto& range : file_ranges) {
+                ranges.push_back(range);
+                chunks.push_back(LoanChunk());
+                chunks.back().file_idx = file_idx;
+            }
+        }
+
+        auto parse = [this, &readers, &ranges, &chunks](unsigned, unsigned task) {
+            parse_range(*(readers[chunks[task].file_idx]), ranges[task], chunks[task]);
+        };
+        {
+            WorkStealingPool pool(num_threads);
+            pool.run(static_cast<unsigned>(ranges.size()), parse);
+        }
+
+        for (const auto& chunk : chunks) {
+            for (const auto& message : chunk.messages) {
+                info_msg(message);
+            }
+        }
+
+        std::vector<FileCounts> file_counts;
+        append_chunks(chunks, stats_files.size(), _loans, _loan_infos, _metrics, file_counts);
+
+        size_t num_rows = 0;
+        for (unsigned file_idx = 0; file_idx < stats_files.size(); ++file_idx) {
+            const auto& file = file_counts[file_idx];
+            info_msg("Initializing from " + stats_files[file_idx] + " done, " +
+                boost::lexical_cast<LCString>(file.num_rows) + " rows, " +
+                boost::lexical_cast<LCString>(file.num_loans) + " loans, " +
+                boost::lexical_cast<LCString>(file.counts.skipped_loans) + " skipped, " +
+                boost::lexical_cast<LCString>(file.counts.young_loans) + " young, " +
+                boost::lexical_cast<LCString>(file.counts.removed_expired_loans) + " removed or expired, " +
+                boost::lexical_cast<LCString>(file.duplicates) + " duplicates");
+            _skipped_loans += file.counts.skipped_loans;
+            _young_loans += file.counts.young_loans;
+            _removed_expired_loans += file.counts.removed_expired_loans;
+            num_rows += file.num_rows;
+        }
+        info_throughput(num_bytes, num_rows, std::chrono::steady_clock::now() - start);
+    }
+
+    // The averages are taken over the loans however they were loaded, so the log is the same with or without a snapshot
+    //
+    void info_averages() const
+    {
+        find_average(Loan::ACC_OPEN_PAST_24MTHS);
+        find_average(Loan::FUNDED_AMNT);
+        find_average(Loan::ANNUAL_INCOME);
+        find_average(Loan::DEBT_TO_INCOME_RATIO);
+        find_average(Loan::DELINQ_2YRS);
+        find_average(Loan::EARLIEST_CREDIT_LINE);
+        find_average(Loan::EMP_LENGTH);
+        find_average(Loan::INQ_LAST_6MTHS);
+        find_average(Loan::MTHS_SINCE_LAST_DELINQ);
+        find_average(Loan::REVOL_UTILIZATION);
+        find_average(Loan::TOTAL_ACC);
+        find_average(Loan::DESC_WORD_COUNT);
+    }
+
+    void parse_range(const MappedCSVReader& in, MappedCSVReader::Range range, LoanChunk& chunk) const
+    {
+        try {
             RawLoan raw_loan;
 
-            while (in.read_row(
-                raw_loan.acc_open_past_24mths,
-                raw_loan.funded_amnt,
-                raw_loan.annual_inc,
-                raw_loan.grade,
-                raw_loan.dti,
-                raw_loan.delinq_2yrs, 
-                raw_loan.earliest_cr_line, 
-                raw_loan.emp_length, 
-                raw_loan.home_ownership,
-                raw_loan.is_inc_v,
-                raw_loan.inq_last_6mths,
-                raw_loan.purpose, 
-                raw_loan.mths_since_last_delinq, 
-                raw_loan.pub_rec,
-                raw_loan.revol_util, 
-                raw_loan.addr_state,
-                raw_loan.total_acc,
-                raw_loan.desc,
-                raw_loan.loan_status,
-                raw_loan.issue_d,
-                raw_loan.term,
-                raw_loan.installment, 
-                raw_loan.int_rate,
-                raw_loan.total_pymnt,
-                raw_loan.out_prncp,
-                raw_loan.out_prncp_inv,
-                raw_loan.total_rec_int,
-                raw_loan.total_rec_prncp)) {
-
-                bool parsed_row_ok = check_loan(raw_loan);
+            while (in.read_row(range, raw_loan.fields())) {
+
+                bool parsed_row_ok = check_loan(raw_loan, chunk.counts, chunk.messages);
                 if (!parsed_row_ok) {
                     continue;
                 }
 
                 Loan loan;
                 LoanInfo loan_info;
-                
-                bool parsed_loan_ok = normalize_loan_data(raw_loan, loan, loan_info);
+                LoanMetric metric;
+
+                bool parsed_loan_ok = normalize_loan_data(raw_loan, loan, loan_info, metric, chunk.messages);
                 if (parsed_loan_ok) {
-                    // Assign the rowid of the loan to be the current last index in the loans list
-                    //
-                    loan.rowid = _loans.size();
-                    _loans.push_back(loan);
-                    _loan_infos.push_back(loan_info);
+                    LoanValue id = no_loan_id;
+                    if (!boost::conversion::try_lexical_convert(raw_loan.id.data(), raw_loan.id.size(), id)) {
+                        id = no_loan_id;
+                    }
+                    chunk.ids.push_back(id);
+                    chunk.loans.push_back(loan);
+                    chunk.loan_infos.push_back(loan_info);
+                    chunk.metrics.push_back(metric);
                 }
             }
+        }
+        catch (...) {
+            chunk.error = std::current_exception();
+        }
+        chunk.num_rows = range.num_rows;
+    }
 
-            info_msg("Initializing from " + stats_file_path.string() + " done.");
-            find_average(Loan::ACC_OPEN_PAST_24MTHS);
-            find_average(Loan::FUNDED_AMNT);
-            find_average(Loan::ANNUAL_INCOME);
-            find_average(Loan::DEBT_TO_INCOME_RATIO);
-            find_average(Loan::DELINQ_2YRS);
-            find_average(Loan::EARLIEST_CREDIT_LINE);
-            find_average(Loan::EMP_LENGTH);
-            find_average(Loan::INQ_LAST_6MTHS);
-            find_average(Loan::MTHS_SINCE_LAST_DELINQ);
-            find_average(Loan::REVOL_UTILIZATION);
-            find_average(Loan::TOTAL_ACC);
-            find_average(Loan::DESC_WORD_COUNT);
-        } else {
-            info_msg("error: " + stats_file_path.string() + " not found");
+    // Appends the loans of the chunks in order, dropping loans whose id was seen before so a loan listed
+    // in several files is only loaded from the first. A parse error is thrown again here for the first
+    // chunk that had one.
+    //
+    void append_chunks(const std::vector<LoanChunk>& chunks, const size_t num_files, LoanVector& loans,
+        LoanInfoVector& loan_infos, LoanMetrics& metrics, std::vector<FileCounts>& file_counts) const
+    {
+        size_t num_loans = 0;
+        for (const auto& chunk : chunks) {
+            num_loans += chunk.loans.size();
+        }
+
+        std::unordered_set<LoanValue> seen_ids;
+        seen_ids.reserve(num_loans);
+        file_counts.assign(num_files, FileCounts());
+
+        for (const auto& chunk : chunks) {
+            if (chunk.error) {
+                std::rethrow_exception(chunk.error);
+            }
+
+            auto& file = file_counts[chunk.file_idx];
+            for (size_t i = 0; i < chunk.loans.size(); ++i) {
+                if ((chunk.ids[i] != no_loan_id) && !seen_ids.insert(chunk.ids[i]).second) {
+                    ++file.duplicates;
+                    continue;
+                }
+
+                // Assign the rowid of the loan to be the current last index in the loans list
+                //
+                Loan loan = chunk.loans[i];
+                loan.rowid = loans.size();
+                loans.push_back(loan);
+                loan_infos.push_back(chunk.loan_infos[i]);
+                metrics.push_back(chunk.metrics[i]);
+                ++file.num_loans;
+            }
+
+            file.counts.skipped_loans += chunk.counts.skipped_loans;
+            file.counts.young_loans += chunk.counts.young_loans;
+            file.counts.removed_expired_loans += chunk.counts.removed_expired_loans;
+            file.num_rows += chunk.num_rows;
+        }
+    }
+
+    // Parses the stats files again one after the other on this thread alone and checks the loans are the same
+    // as the ones loaded, the diagnostics of the rows were printed by the load already when it parsed them
+    //
+    void verify_load(const StringVector& stats_files) const
+    {
+        std::vector<LoanChunk> chunks(stats_files.size());
+        for (unsigned file_idx = 0; file_idx < stats_files.size(); ++file_idx) {
+            MappedCSVReader in(stats_files[file_idx]);
+            in.read_header(RawLoan::columns());
+            chunks[file_idx].file_idx = file_idx;
+            parse_range(in, in.split(1).front(), chunks[file_idx]);
+        }
+
+        LoanVector loans;
+        LoanInfoVector loan_infos;
+        LoanMetrics metrics;
+        std::vector<FileCounts> file_counts;
+        append_chunks(chunks, stats_files.size(), loans, loan_infos, metrics, file_counts);
+
+        LCString mismatch;
+        if (loans.size() != _loans.size()) {
+            mismatch = boost::lexical_cast<LCString>(loans.size()) + " loans instead of " +
+                boost::lexical_cast<LCString>(_loans.size());
+        }
+
+        for (size_t i = 0; mismatch.empty() && (i < _loans.size()); ++i) {
+            const auto& info = loan_infos[i];
+            const auto& other = _loan_infos[i];
+            const auto serial_metric = metrics.get(static_cast<unsigned>(i));
+            const auto metric = _metrics.get(static_cast<unsigned>(i));
+
+            bool same_loan = (std::memcmp(&loans[i], &_loans[i], sizeof(Loan)) == 0);
+            bool same_info = (info.loan_status == other.loan_status) && (info.issue_datetime == other.issue_datetime) &&
+                (info.number_of_payments == other.number_of_payments) && (info.installment == other.installment) &&
+                (info.int_rate == other.int_rate) && (info.total_pymnt == other.total_pymnt) &&
+                (info.out_prncp == other.out_prncp) && (info.out_prncp_inv == other.out_prncp_inv) &&
+                (info.profit == other.profit) && (info.principal == other.principal) && (info.lost == other.lost) &&
+                (info.defaulted == other.defaulted);
+            bool same_metric = (serial_metric.profit == metric.profit) && (serial_metric.principal == metric.principal) &&
+                (serial_metric.lost == metric.lost) && (serial_metric.int_rate == metric.int_rate) &&
+                (serial_metric.defaulted == metric.defaulted) && (serial_metric.volume_month == metric.volume_month);
+
+            if (!same_loan || !same_info || !same_metric) {
+                mismatch = "loan " + boost::lexical_cast<LCString>(i) + " differs";
+            }
+        }
+
+        // The closed form amortization against the month by month loop, the defaulted amount is recovered from the loss
+        //
+        for (size_t i = 0; mismatch.empty() && (i < _loans.size()); ++i) {
+            const auto& info = _loan_infos[i];
+            AmortizationTerms terms;
+            terms.funded_amnt = static_cast<double>(_loans[i].funded_amnt);
+            terms.int_rate = info.int_rate;
+            terms.number_of_payments = info.number_of_payments;
+            terms.installment = info.installment;
+            terms.total_pymnt = info.total_pymnt;
+            terms.defaulted = (info.defaulted != 0);
+            terms.defaulted_amount = info.lost * terms.funded_amnt / 25.0;
+
+            Amortization by_month = amortize_by_month(terms);
+            if (!amortization_close(info.profit, by_month.profit, max_amortization_error) ||
+                !amortization_close(info.principal, by_month.principal, max_amortization_error) ||
+                !amortization_close(info.lost, by_month.lost, max_amortization_error)) {
+                mismatch = "loan " + boost::lexical_cast<LCString>(i) + " amortization differs from the monthly schedule";
+            }
+        }
+
+        if (!mismatch.empty()) {
+            info_msg("error: loaded loans do not match the serial parse, " + mismatch);
             exit(-1);
         }
+        info_msg("Verified load: " + boost::lexical_cast<LCString>(_loans.size()) + " loans match the serial parse and the monthly amortization");
+    }
+
+    // The snapshot path given by the "snapshot" argument, empty when snapshots are turned off
+    //
+    LCString get_snapshot_path(const StringVector& stats_files) const
+    {
+        LCString snapshot = _args["snapshot"].as<LCString>();
+        if (snapshot == "none") {
+            return LCString();
+        }
+        return snapshot.empty() ? (stats_files.front() + ".snapshot") : snapshot;
+    }
+
+    LoanSnapshot make_snapshot(const StringVector& stats_files, const LCString& snapshot_path) const
+    {
+        // Everything besides the stats file the normalized loans depend on
+        //
+        LCString options = _args["grades"].as<LCString>() + '|' + _args["states"].as<LCString>() + '|' +
+            boost::lexical_cast<LCString>(_args["young_loans_in_days"].as<unsigned>());
+        return LoanSnapshot(snapshot_path, stats_files, _conversion_filters, _last_date_for_full_month_for_volume,
+            EarliestCreditLine::now, options);
+    }
+
+    bool load_snapshot(const StringVector& stats_files)
+    {
+        LCString snapshot_path = get_snapshot_path(stats_files);
+        if (snapshot_path.empty()) {
+            return false;
+        }
+
+        LoanSnapshot snapshot = make_snapshot(stats_files, snapshot_path);
+        LoanSnapshot::Counts counts;
+        LCString reason;
+        bool loaded = false;
+
+        auto start = std::chrono::steady_clock::now();
+        try {
+            loaded = snapshot.load(_loans, _loan_infos, _metrics, counts, _args["verify_load"].as<bool>(), reason);
+        }
+        catch (boost::interprocess::interprocess_exception& e) {
+            reason = e.what();
+        }
+
+        if (!loaded) {
+            info_msg("Not using snapshot " + snapshot_path + ": " + reason);
+            _loans.clear();
+            _loan_infos.clear();
+            _metrics = LoanMetrics();
+            return false;
+        }
+
+        _skipped_loans = counts.skipped_loans;
+        _young_loans = counts.young_loans;
+        _removed_expired_loans = counts.removed_expired_loans;
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        info_msg("Loaded " + boost::lexical_cast<LCString>(_loans.size()) + " loans from snapshot " + snapshot_path + " in " +
+            boost::lexical_cast<LCString>(static_cast<unsigned>(elapsed.count() * 1000)) + " ms");
+        return true;
     }
 
-    virtual bool check_loan(RawLoan& loan)
+    void save_snapshot(const StringVector& stats_files)
+    {
+        LCString snapshot_path = get_snapshot_path(stats_files);
+        if (snapshot_path.empty()) {
+            return;
+        }
+
+        LoanSnapshot snapshot = make_snapshot(stats_files, snapshot_path);
+        LoanSnapshot::Counts counts;
+        counts.skipped_loans = _skipped_loans;
+        counts.young_loans = _young_loans;
+        counts.removed_expired_loans = _removed_expired_loans;
+        LCString reason;
+        bool saved = false;
+
+        try {
+            saved = snapshot.save(_loans, _loan_infos, _metrics, counts, reason);
+        }
+        catch (boost::interprocess::interprocess_exception& e) {
+            reason = e.what();
+        }
+
+        info_msg(saved ? ("Wrote snapshot " + snapshot_path) : ("Could not write snapshot " + snapshot_path + ": " + reason));
+    }
+
+    virtual bool check_loan(const RawLoan& loan, LoanSnapshot::Counts& counts, StringVector& messages) const
     {
         // SKip loans without a loan status or funded amount
         if (loan.loan_status.empty()) {
-            ++_skipped_loans;
+            ++counts.skipped_loans;
             return false;
         }
 
         if (loan.funded_amnt.empty()) {
-            ++_skipped_loans;
+            ++counts.skipped_loans;
             return false;
         }
 
         if (loan.issue_d.empty()) {
-            ++_skipped_loans;
+            ++counts.skipped_loans;
             return false;
         }
 
         // Only look at loans with a valid issue date
         //
-        boost::gregorian::date issue_d(boost::gregorian::from_simple_string(loan.issue_d));		
+        boost::gregorian::date issue_d(string_to_date(loan.issue_d));		
         if (issue_d.is_not_a_date()) {
-            info_msg("Skipping loan, did not find issue_d:" + loan.to_str());
-            ++_skipped_loans;
+            messages.push_back("Skipping loan, did not find issue_d:" + loan.to_str());
+            ++counts.skipped_loans;
             return false;
         }
 
-        // Ignore loans that are too young for consideration
+        // Ignore loans that are too young for consideration, issued after now less young_loans_in_days
         //
-        boost::gregorian::date_duration young_loans_in_days(_args["young_loans_in_days"].as<unsigned>());
-        boost::gregorian::date young_date = _now.date() - young_loans_in_days;
-
-        if (young_date < issue_d) {
-            ++_young_loans;
+        if (_last_date_for_full_month_for_volume < issue_d) {
+            ++counts.young_loans;
             return false;
         }
 
         // Ignore loans that didn't event start
         //
         if ((loan.loan_status == "Removed") || (loan.loan_status == "Expired")) {
-            ++_removed_expired_loans;
+            ++counts.removed_expired_loans;
             return false;
         }
         return true;
@@ -307,7 +667,81 @@ public:
         filter[0]->set_options(&static_options);
     }
 
-    virtual bool normalize_loan_data(const RawLoan& raw_loan, Loan& loan, LoanInfo& loan_info)
+    // Times the converter of every filter over the fields of the stats rows check_loan keeps, num_passes
+    // times over all of them
+    //
+    void benchmark_convert(const unsigned num_passes) const
+    {
+        std::vector<std::unique_ptr<MappedCSVReader>> readers;
+        std::vector<RawLoan> raw_loans;
+        LoanSnapshot::Counts counts = LoanSnapshot::Counts();
+        StringVector messages;      // the load reported the rows check_loan skips already
+
+        for (const auto& stats_file : expand_paths(_args["stats"].as<LCString>())) {
+            readers.push_back(std::unique_ptr<MappedCSVReader>(new MappedCSVReader(stats_file)));
+            readers.back()->read_header(RawLoan::columns());
+
+            RawLoan raw_loan;
+            while (readers.back()->read_row(raw_loan.fields())) {
+                if (check_loan(raw_loan, counts, messages)) {
+                    raw_loans.push_back(raw_loan);
+                }
+            }
+        }
+
+        // The converted values are summed up so the calls are not optimized away
+        //
+        FilterValue checksum = 0;
+        double total_ns = 0.0;
+        for (auto filter_type : _conversion_filters) {
+            const Filter* filter = _filters[filter_type];
+
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned pass = 0; pass < num_passes; ++pass) {
+                for (const auto& raw_loan : raw_loans) {
+                    checksum += filter->convert(raw_loan.get(filter_type));
+                }
+            }
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+            double ns = elapsed.count() / std::max<size_t>(1, raw_loans.size() * num_passes);
+            total_ns += ns;
+            info_msg("Convert " + filter->get_name() + " " + boost::str(boost::format("%.1f") % ns) + " ns/field");
+        }
+
+        info_msg("Convert all " + boost::str(boost::format("%.1f") % total_ns) + " ns/row over " +
+            boost::lexical_cast<LCString>(raw_loans.size()) + " rows, checksum " + boost::lexical_cast<LCString>(checksum));
+    }
+
+    void info_throughput(const size_t num_bytes, const size_t num_rows, const std::chrono::duration<double>& elapsed) const
+    {
+        double seconds = std::max(elapsed.count(), 1e-9);
+        double mb = num_bytes / (1024.0 * 1024.0);
+        info_msg("Parsed " + boost::lexical_cast<LCString>(static_cast<unsigned>(mb)) + " MB, " +
+            boost::lexical_cast<LCString>(num_rows) + " rows in " +
+            boost::lexical_cast<LCString>(static_cast<unsigned>(seconds * 1000)) + " ms, " +
+            boost::lexical_cast<LCString>(static_cast<unsigned>(mb / seconds)) + " MB/s, " +
+            boost::lexical_cast<LCString>(static_cast<unsigned>(num_rows / seconds)) + " rows/s");
+    }
+
+    void info_columns() const
+    {
+        for (unsigned type = 0; type < LoanColumns::num_columns; ++type) {
+            auto loan_value_type = static_cast<Loan::LoanType>(type);
+            const auto& column = _columns.get(loan_value_type);
+            LCString column_name = "rowid";
+            if ((loan_value_type != Loan::ROWID) && (type < _filters.size()) && (_filters[type] != nullptr)) {
+                column_name = _filters[type]->get_name();
+            }
+            info_msg("Column " + column_name + " " + boost::lexical_cast<LCString>(num_loans() * sizeof(LoanValue)) + " -> " +
+                boost::lexical_cast<LCString>(column.size_in_bytes()) + " bytes");
+        }
+        info_msg("Loan columns " + boost::lexical_cast<LCString>(_columns.unpacked_size_in_bytes()) + " -> " +
+            boost::lexical_cast<LCString>(_columns.size_in_bytes()) + " bytes");
+    }
+
+    virtual bool normalize_loan_data(const RawLoan& raw_loan, Loan& loan, LoanInfo& loan_info, LoanMetric& metric,
+        StringVector& messages) const
     {
         loan.acc_open_past_24mths = _filters[Loan::ACC_OPEN_PAST_24MTHS]->convert(raw_loan.acc_open_past_24mths);
         loan.funded_amnt = _filters[Loan::FUNDED_AMNT]->convert(raw_loan.funded_amnt);
@@ -328,8 +762,8 @@ public:
         loan.total_acc = _filters[Loan::TOTAL_ACC]->convert(raw_loan.total_acc);
         loan.desc_word_count = _filters[Loan::DESC_WORD_COUNT]->convert(raw_loan.desc);
 
-        loan_info.loan_status = raw_loan.loan_status;
-        loan_info.issue_datetime = boost::gregorian::date(boost::gregorian::from_simple_string(raw_loan.issue_d));		
+        loan_info.loan_status = raw_loan.loan_status.to_string();
+        loan_info.issue_datetime = string_to_date(raw_loan.issue_d);		
 
         if (raw_loan.term == " 36 months") {
             loan_info.number_of_payments = 36;
@@ -337,19 +771,19 @@ public:
         else if (raw_loan.term == " 60 months") {
             loan_info.number_of_payments = 60;
         } else {
-            std::cout << "unknown number of payments: " << raw_loan.term << "expecting 36 or 60, skipping\n";
+            messages.push_back("unknown number of payments: " + raw_loan.term.to_string() + "expecting 36 or 60, skipping");
             return false;
         }
 
-        loan_info.installment = strtod(raw_loan.installment.c_str(), nullptr);
+        loan_info.installment = string_to_double(raw_loan.installment);
 
-        std::size_t found = raw_loan.int_rate.find_first_not_of(" ");
-        loan_info.int_rate = strtod(raw_loan.int_rate.substr(found, raw_loan.int_rate.length() - 1 - found).c_str(), nullptr);
-        loan_info.total_pymnt = strtod(raw_loan.total_pymnt.c_str(), nullptr);
-        loan_info.out_prncp = strtod(raw_loan.out_prncp.c_str(), nullptr);
-        loan_info.out_prncp_inv = strtod(raw_loan.out_prncp_inv.c_str(), nullptr);
-        double total_received_interest = strtod(raw_loan.total_rec_int.c_str(), nullptr);
-        double total_received_principal = strtod(raw_loan.total_rec_prncp.c_str(), nullptr);
+        std::size_t found = raw_loan.int_rate.find_first_not_of(' ');
+        loan_info.int_rate = string_to_double(raw_loan.int_rate.substr(found, raw_loan.int_rate.length() - 1 - found));
+        loan_info.total_pymnt = string_to_double(raw_loan.total_pymnt);
+        loan_info.out_prncp = string_to_double(raw_loan.out_prncp);
+        loan_info.out_prncp_inv = string_to_double(raw_loan.out_prncp_inv);
+        double total_received_interest = string_to_double(raw_loan.total_rec_int);
+        double total_received_principal = string_to_double(raw_loan.total_rec_prncp);
 
         double defaulted_amount = 0.0;
         if ((loan_info.loan_status == "Charged Off") || (loan_info.loan_status == "Default")) {
@@ -362,82 +796,65 @@ public:
             loan_info.defaulted = 0;
         }
 
-        double loan_profit = 0.0, loan_principal = 0.0, loan_lost = 0.0;
-        unsigned elapsed = loan_info.number_of_payments;
-        double balance = static_cast<double>(loan.funded_amnt);
-        double monthly_payment = loan_info.installment;
-        double rate = loan_info.int_rate;
-        double ratio = 25.0 / balance;
-        double payments = 0.0;
-        while (elapsed > 0) {
-            --elapsed;
-            // Interest and service charge for the whole loan (not just me)
-            //
-            double interest = balance * rate / 1200.0;
-            double service = 0.01 * monthly_payment;
-            payments += monthly_payment;
-            if (loan_info.defaulted && payments > loan_info.total_pymnt) {
-                loan_profit -= defaulted_amount * ratio;
-                loan_lost += defaulted_amount * ratio;
-                break;
-            }
-
-            // Compute my ratio of the profit
-            //
-            loan_profit += (interest - service) * ratio;
-            loan_principal += balance * ratio;
-            balance -= monthly_payment;
-        }
-
-        // sys.stderr.write("Calculated profit=%.2f principal=%.2f loss=%.2f ... ")
-        // sys.stderr.write("csv total_received_interest=%.2f total_received_principal=%.2f loss=%.2f\n" %
-        // (loan_profit, loan_principal, loan_lost, total_received_interest,
-        // total_received_principal, loan_array[LOAN_ENUM_lost]))
-        loan_info.profit = loan_profit;
-        loan_info.principal = loan_principal;
-        loan_info.lost = loan_lost;
+        AmortizationTerms terms;
+        terms.funded_amnt = static_cast<double>(loan.funded_amnt);
+        terms.int_rate = loan_info.int_rate;
+        terms.number_of_payments = loan_info.number_of_payments;
+        terms.installment = loan_info.installment;
+        terms.total_pymnt = loan_info.total_pymnt;
+        terms.defaulted = (loan_info.defaulted != 0);
+        terms.defaulted_amount = defaulted_amount;
+
+        Amortization amortization = amortize(terms);
+        loan_info.profit = amortization.profit;
+        loan_info.principal = amortization.principal;
+        loan_info.lost = amortization.lost;
+
+        // The part of the loan get_nar needs, the month is checked here once instead of on every test
+        //
+        metric.profit = loan_info.profit;
+        metric.principal = loan_info.principal;
+        metric.lost = loan_info.lost;
+        metric.int_rate = loan_info.int_rate;
+        metric.defaulted = static_cast<std::uint8_t>(loan_info.defaulted);
+        metric.volume_month = (loan_info.issue_datetime.year() == _last_date_for_full_month_for_volume.year()) &&
+            (loan_info.issue_datetime.month() == _last_date_for_full_month_for_volume.month());
         return true;
     }
 
     LoanReturn get_nar(const LoanValueVector& invested) const
     {
-        unsigned defaulted = 0, per_month = 0;
-        double profit = 0.0, principal = 0.0, lost = 0.0, rate = 0.0;
-
-        for (auto row_id : invested) {
-            unsigned idx = static_cast<unsigned>(row_id);
-            profit += _loan_infos[idx].profit;
-            principal += _loan_infos[idx].principal;
-            lost += _loan_infos[idx].lost;
-            defaulted += _loan_infos[idx].defaulted;
-            rate += _loan_infos[idx].int_rate;
-            // Count loan volume
-            //
-            if ((_loan_infos[idx].issue_datetime.year() == _last_date_for_full_month_for_volume.year()) &&
-                (_loan_infos[idx].issue_datetime.month() == _last_date_for_full_month_for_volume.month())) {
-                ++per_month;
-            }
-        }
+        LoanReturnSums sums;
+        add_nar_sums(invested, sums);
+        return get_nar(sums);
+    }
 
-        LoanReturn loan_return;
-        loan_return.num_loans = invested.size();
+    void add_nar_sums(const LoanValueVector& invested, LoanReturnSums& sums) const
+    {
+        _metrics.add_invested(invested, sums);
+    }
+
+    LoanReturn get_nar(const LoanReturnSums& sums) const
+    {
+        LoanReturn loan_return = LoanReturn();
+        loan_return.num_loans = sums.num_loans;
 
         if (loan_return.num_loans > 0) {
 
-            if (principal == 0.0) {
+            if (sums.principal == 0.0) {
                 loan_return.net_apy = 0.0;
             }
             else {
                 // Calculate the Net APR
                 //
-                loan_return.net_apy = 100.0 * (pow(1.0 + profit / principal, 12) - 1.0);
+                loan_return.net_apy = 100.0 * (pow(1.0 + sums.profit / sums.principal, 12) - 1.0);
             }
 
-            loan_return.expected_apy = rate / loan_return.num_loans;
-            loan_return.pct_defaulted = 100.0 * defaulted / loan_return.num_loans;
-            loan_return.avg_default_loss = (defaulted > 0) ? (lost / defaulted) : 0.0;
-            loan_return.loans_per_month = per_month;
-            loan_return.num_defaulted = defaulted;
+            loan_return.expected_apy = sums.rate / loan_return.num_loans;
+            loan_return.pct_defaulted = 100.0 * sums.defaulted / loan_return.num_loans;
+            loan_return.avg_default_loss = (sums.defaulted > 0) ? (sums.lost / sums.defaulted) : 0.0;
+            loan_return.loans_per_month = sums.per_month;
+            loan_return.num_defaulted = sums.defaulted;
         }
         return loan_return;
     }
@@ -452,8 +869,81 @@ public:
         return _loans.size();
     }
 
+    const LCString& get_filter_name(const Loan::LoanType loan_value_type) const
+    {
+        return _filters[loan_value_type]->get_name();
+    }
+
+    const LoanColumns& get_columns() const
+    {
+        return _columns;
+    }
+
+    const LoanBitmapIndex& get_bitmap_index() const
+    {
+        return _bitmap_index;
+    }
+
+    // The full information of every loan, only used for reporting, get_nar uses get_metrics()
+    //
+    const LoanInfoVector& get_loan_infos() const
+    {
+        return _loan_infos;
+    }
+
+    const LoanMetrics& get_metrics() const
+    {
+        return _metrics;
+    }
+
+    // The memory the scans read: the loans, their columns, the bitmap index and the metrics
+    //
+    MemoryRegions get_memory_regions() const
+    {
+        MemoryRegions regions;
+        regions.push_back(std::make_pair(static_cast<const void*>(_loans.data()), _loans.size() * sizeof(Loan)));
+        _columns.add_memory_regions(regions);
+        _bitmap_index.add_memory_regions(regions);
+        _metrics.add_memory_regions(regions);
+        return regions;
+    }
+
+    // A copy for the workers of another NUMA node. It is made by the calling thread, which touches its
+    // pages first so they are placed on that thread's node. The workers never read the loan infos, the
+    // copy does not have them.
+    //
+    LoanData* replicate() const
+    {
+        return new LoanData(*this, WithoutLoanInfos());
+    }
+
 private:
+    struct WithoutLoanInfos {};
+
+    // Copies everything but the loan infos, the largest and coldest part of the loans, so replicate() never
+    // copies them only to free them again
+    //
+    LoanData(const LoanData& other, WithoutLoanInfos) :
+        _args(other._args),
+        _conversion_filters(other._conversion_filters),
+        _filters(other._filters),
+        _worker_idx(other._worker_idx),
+        _row(other._row),
+        _skipped_loans(other._skipped_loans),
+        _young_loans(other._young_loans),
+        _removed_expired_loans(other._removed_expired_loans),
+        _last_date_for_full_month_for_volume(other._last_date_for_full_month_for_volume),
+        _labels(other._labels),
+        _loans(other._loans),
+        _columns(other._columns),
+        _bitmap_index(other._bitmap_index),
+        _metrics(other._metrics),
+        _now(other._now)
+    {
+    }
+
         const Arguments&                        _args;
+        const LoanTypeVector                    _conversion_filters;
         FilterPtrVector                         _filters;
         const int								_worker_idx;
         unsigned								_row;
@@ -464,6 +954,9 @@ private:
         StringVector                            _labels;
         LoanVector	        					_loans;
         LoanInfoVector                          _loan_infos;
+        LoanColumns                             _columns;
+        LoanBitmapIndex                         _bitmap_index;
+        LoanMetrics                             _metrics;
         boost::posix_time::ptime				_now;
 };
 
@@ -0,0 +1,190 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_LOAN_METRICS_HPP__
+#define __LC_LOAN_METRICS_HPP__
+
+#include <cstdint>
+#include <vector>
+#include "Types.hpp"
+#include "Loan.hpp"
+#include "Utilities.hpp"
+#include "HugePages.hpp"
+
+namespace lc
+{
+
+// The values of one loan get_nar sums up, filled in by LoanData::normalize_loan_data
+//
+struct LoanMetric
+{
+    double                          profit;
+    double                          principal;
+    double                          lost;
+    double                          int_rate;
+    std::uint8_t                    defaulted;
+    bool                            volume_month;       // issued in the month loans_per_month counts
+};
+
+//
+// The values get_nar sums up, one array per value indexed by rowid like the loan columns, so summing
+// never touches a LoanInfo (with its strings and dates), which is only kept for reporting.
+//
+// The volume month flags are a bitset laid out like the scan match masks, a whole word of matched
+// loans is counted with one popcount. Scans add the loans they match straight from their match masks
+// or selections, so no list of rowids is built.
+//
+class LoanMetrics
+{
+public:
+    typedef std::vector<double, HugePageAllocator<double>> DoubleVector;
+    typedef std::vector<std::uint8_t, HugePageAllocator<std::uint8_t>> FlagVector;
+    typedef std::vector<std::uint64_t, HugePageAllocator<std::uint64_t>> BitVector;
+
+    LoanMetrics() : _num_loans(0) {}
+
+    void reserve(const size_t num_loans)
+    {
+        _profit.reserve(num_loans);
+        _principal.reserve(num_loans);
+        _lost.reserve(num_loans);
+        _int_rate.reserve(num_loans);
+        _defaulted.reserve(num_loans);
+        _volume_month.reserve((num_loans + 63) / 64);
+    }
+
+    // Appends the metric of loan rowid num_loans()
+    //
+    void push_back(const LoanMetric& metric)
+    {
+        _profit.push_back(metric.profit);
+        _principal.push_back(metric.principal);
+        _lost.push_back(metric.lost);
+        _int_rate.push_back(metric.int_rate);
+        _defaulted.push_back(metric.defaulted);
+
+        if (_num_loans % 64 == 0) {
+            _volume_month.push_back(0);
+        }
+        if (metric.volume_month) {
+            _volume_month.back() |= std::uint64_t(1) << (_num_loans % 64);
+        }
+        ++_num_loans;
+    }
+
+    size_t num_loans() const
+    {
+        return _num_loans;
+    }
+
+    LoanMetric get(const unsigned idx) const
+    {
+        LoanMetric metric;
+        metric.profit = _profit[idx];
+        metric.principal = _principal[idx];
+        metric.lost = _lost[idx];
+        metric.int_rate = _int_rate[idx];
+        metric.defaulted = _defaulted[idx];
+        metric.volume_month = volume_month(idx);
+        return metric;
+    }
+
+    inline bool volume_month(const unsigned idx) const
+    {
+        return ((_volume_month[idx / 64] >> (idx % 64)) & 1) != 0;
+    }
+
+    inline void add(const unsigned idx, LoanReturnSums& sums) const
+    {
+        sums.profit += _profit[idx];
+        sums.principal += _principal[idx];
+        sums.lost += _lost[idx];
+        sums.defaulted += _defaulted[idx];
+        sums.rate += _int_rate[idx];
+        sums.per_month += volume_month(idx);
+    }
+
+    // Adds the loans listed in invested
+    //
+    void add_invested(const LoanValueVector& invested, LoanReturnSums& sums) const
+    {
+        for (auto row_id : invested) {
+            add(static_cast<unsigned>(row_id), sums);
+        }
+        sums.num_loans += invested.size();
+    }
+
+    // Adds the num_selected loans of a columnar scan selection
+    //
+    void add_selected(const unsigned* selection, const unsigned num_selected, LoanReturnSums& sums) const
+    {
+        for (unsigned i = 0; i < num_selected; ++i) {
+            add(selection[i], sums);
+        }
+        sums.num_loans += num_selected;
+    }
+
+    // Adds the loans set in a match mask, bit j of mask[i] is loan first_row + 64 * i + j, first_row
+    // must be a multiple of 64
+    //
+    void add_masked(const std::uint64_t* mask, const unsigned num_words, const unsigned first_row, LoanReturnSums& sums) const
+    {
+        const std::uint64_t* volume_month = &(_volume_month[first_row / 64]);
+        unsigned row = first_row;
+
+        for (unsigned i = 0; i < num_words; ++i, row += 64) {
+            std::uint64_t word = mask[i];
+            if (word == 0) {
+                continue;
+            }
+
+            sums.num_loans += population_count(word);
+            sums.per_month += population_count(word & volume_month[i]);
+
+            for (; word != 0; word &= word - 1) {
+                unsigned idx = row + count_trailing_zeros(word);
+                sums.profit += _profit[idx];
+                sums.principal += _principal[idx];
+                sums.lost += _lost[idx];
+                sums.defaulted += _defaulted[idx];
+                sums.rate += _int_rate[idx];
+            }
+        }
+    }
+
+    size_t size_in_bytes() const
+    {
+        return _num_loans * (4 * sizeof(double) + sizeof(std::uint8_t)) + _volume_month.size() * sizeof(std::uint64_t);
+    }
+
+    void add_memory_regions(MemoryRegions& regions) const
+    {
+        for (auto column : { &_profit, &_principal, &_lost, &_int_rate }) {
+            regions.push_back(std::make_pair(static_cast<const void*>(column->data()), column->size() * sizeof(double)));
+        }
+        regions.push_back(std::make_pair(static_cast<const void*>(_defaulted.data()), _defaulted.size()));
+        regions.push_back(std::make_pair(static_cast<const void*>(_volume_month.data()), _volume_month.size() * sizeof(std::uint64_t)));
+    }
+
+private:
+    size_t                                      _num_loans;
+    DoubleVector                                _profit;
+    DoubleVector                                _principal;
+    DoubleVector                                _lost;
+    DoubleVector                                _int_rate;
+    FlagVector                                  _defaulted;
+    BitVector                                   _volume_month;
+};
+
+};
+
+#endif // __LC_LOAN_METRICS_HPP__
@@ -18,5 +18,6 @@ const LCString LoanPurpose::sqlite_type = "INT";
 const LCString LoanPurpose::csv_name = "purpose";
 const LCString LoanPurpose::name = "LoanPurpose";
 std::map<LCString, FilterValue> LoanPurpose::_conversion_table;
+PerfectHashMap LoanPurpose::_lookup;
 const FilterValueVector* LoanPurpose::options = nullptr;
 const Filter::Relation LoanPurpose::relation = Filter::Relation::MASK;
\ No newline at end of file
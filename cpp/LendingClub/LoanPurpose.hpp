@@ -16,6 +16,7 @@ Created on July 28, 2014
 #include "Filter.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
+#include "PerfectHashMap.hpp"
 
 namespace lc
 {
@@ -52,6 +53,7 @@ public:
             for (unsigned i = 0; i < 14; ++i) {
                 purpose_bitmap.push_back(1 << i);
             }      
+            _lookup.build(_conversion_table);
             options = new FilterValueVector(power_bitset(purpose_bitmap));
         }
     }
@@ -74,11 +76,12 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
-        auto it = _conversion_table.find(raw_data);
-        assert(it != _conversion_table.end());
-        return (it->second);
+        FilterValue value = 0;
+        bool found = _lookup.find(raw_data, value);
+        assert(found);
+        return value;
     }
 
     virtual const LCString get_string_value() const
@@ -110,6 +113,7 @@ public:
 
 private:
     static std::map<LCString, FilterValue>   _conversion_table;
+    static PerfectHashMap                    _lookup;
 };
 
 };
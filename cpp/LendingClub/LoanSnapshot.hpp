@@ -0,0 +1,477 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_LOAN_SNAPSHOT_HPP__
+#define __LC_LOAN_SNAPSHOT_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include "Types.hpp"
+#include "Loan.hpp"
+#include "LoanMetrics.hpp"
+
+namespace lc
+{
+
+//
+// Binary snapshot of the normalized loans, so later runs on the same stats file skip the CSV parse,
+// the conversions and the amortization of every loan.
+//
+// The file is a fixed header followed by the Loan, LoanMetric and LoanInfo records of every loan
+// and the table of loan status strings. The header records everything the normalized loans depend
+// on: the layout of the records, the names, total size, latest modification time and checksums of the
+// stats files, the young loan cutoff date and the grades/states options. A snapshot that does not match all of them
+// is ignored and rewritten.
+//
+// Loading only hashes the first and last sample_size bytes of every stats file on top of the sizes and
+// times, so it does not grow with the stats files. The checksum of the whole files is written by save()
+// and only checked on load when asked for.
+//
+// The earliest credit line is converted to an age in seconds at the time the run started, the header
+// keeps that time so the ages of an older snapshot are moved forward to the time of the run loading it.
+//
+class LoanSnapshot
+{
+public:
+    static const std::uint32_t version = 5;       // 3: closed form amortization, 4: head and tail checksum, 5: clock
+
+    // Bytes hashed at each end of every stats file on load
+    static const size_t sample_size = 4096;
+
+    // Loans the CSV parse dropped, reported again when loading from the snapshot
+    struct Counts
+    {
+        std::uint32_t                   skipped_loans;
+        std::uint32_t                   young_loans;
+        std::uint32_t                   removed_expired_loans;
+    };
+
+    LoanSnapshot(const LCString& snapshot_path, const StringVector& source_paths, const LoanTypeVector& conversion_filters,
+        const boost::gregorian::date& cutoff_date, const boost::posix_time::ptime& clock, const LCString& options) :
+        _snapshot_path(snapshot_path),
+        _source_paths(source_paths)
+    {
+        std::memset(&_expected, 0, sizeof(_expected));
+        std::memcpy(_expected.magic, "LCSNAPSH", sizeof(_expected.magic));
+        _expected.version = version;
+        _expected.header_size = sizeof(Header);
+
+        LCString schema = "Loan=" + boost::lexical_cast<LCString>(sizeof(Loan)) +
+            " LoanMetric=" + boost::lexical_cast<LCString>(sizeof(LoanMetric)) +
+            " LoanRecord=" + boost::lexical_cast<LCString>(sizeof(LoanRecord)) + " filters=";
+        for (auto filter_type : conversion_filters) {
+            schema += boost::lexical_cast<LCString>(static_cast<unsigned>(filter_type)) + ',';
+        }
+        _expected.schema_hash = hash_bytes(schema.data(), schema.size());
+        _expected.options_hash = hash_bytes(options.data(), options.size());
+        _expected.cutoff_year = static_cast<std::uint16_t>(cutoff_date.year());
+        _expected.cutoff_month = static_cast<std::uint8_t>(cutoff_date.month());
+        _expected.cutoff_day = static_cast<std::uint8_t>(cutoff_date.day());
+        _expected.clock = (clock - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_seconds();
+    }
+
+    const LCString& get_path() const
+    {
+        return _snapshot_path;
+    }
+
+    // Fills in the loans from the snapshot, returns false with the reason when there is no usable snapshot.
+    // The stats files are read in full only with full_checksum.
+    //
+    bool load(LoanVector& loans, LoanInfoVector& loan_infos, LoanMetrics& metrics, Counts& counts, const bool full_checksum,
+        LCString& reason)
+    {
+        if (!boost::filesystem::exists(_snapshot_path)) {
+            reason = "no snapshot";
+            return false;
+        }
+
+        boost::interprocess::file_mapping file(_snapshot_path.c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+        const char* data = static_cast<const char*>(region.get_address());
+        const size_t size = region.get_size();
+
+        Header header;
+        if (size < sizeof(header)) {
+            reason = "truncated header";
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+
+        if ((std::memcmp(header.magic, _expected.magic, sizeof(header.magic)) != 0) || (header.version != version) ||
+            (header.header_size != sizeof(Header)) || (header.schema_hash != _expected.schema_hash)) {
+            reason = "different version or layout";
+            return false;
+        }
+
+        if (header.options_hash != _expected.options_hash) {
+            reason = "different options";
+            return false;
+        }
+
+        if ((header.cutoff_year != _expected.cutoff_year) || (header.cutoff_month != _expected.cutoff_month) ||
+            (header.cutoff_day != _expected.cutoff_day)) {
+            reason = "different young loan cutoff date";
+            return false;
+        }
+
+        if (!stat_source(reason)) {
+            return false;
+        }
+
+        if ((header.source_size != _expected.source_size) || (header.source_mtime != _expected.source_mtime)) {
+            reason = "stats files changed";
+            return false;
+        }
+
+        if (!sample_source(reason)) {
+            return false;
+        }
+
+        if (header.source_sample_checksum != _expected.source_sample_checksum) {
+            reason = "stats files checksum changed";
+            return false;
+        }
+
+        if (full_checksum) {
+            if (!checksum_source(reason)) {
+                return false;
+            }
+
+            if (header.source_checksum != _expected.source_checksum) {
+                reason = "stats files full checksum changed";
+                return false;
+            }
+        }
+
+        const size_t num_loans = static_cast<size_t>(header.num_loans);
+        const size_t records_size = num_loans * (sizeof(Loan) + sizeof(LoanMetric) + sizeof(LoanRecord));
+        if (size < sizeof(header) + records_size) {
+            reason = "truncated records";
+            return false;
+        }
+
+        // The records are copied out in bulk, the mapping goes away when we return
+        //
+        const char* p = data + sizeof(header);
+        loans.resize(num_loans);
+        std::memcpy(loans.data(), p, num_loans * sizeof(Loan));
+        p += num_loans * sizeof(Loan);
+
+        // A loan without an earliest credit line converted to 0 and stays 0
+        //
+        const LoanValue clock_delta = static_cast<LoanValue>(_expected.clock - header.clock);
+        if (clock_delta != 0) {
+            for (auto& loan : loans) {
+                if (loan.earliest_credit_line != 0) {
+                    loan.earliest_credit_line += clock_delta;
+                }
+            }
+        }
+
+        std::vector<LoanMetric> loan_metrics(num_loans);
+        std::memcpy(loan_metrics.data(), p, num_loans * sizeof(LoanMetric));
+        p += num_loans * sizeof(LoanMetric);
+
+        std::vector<LoanRecord> records(num_loans);
+        std::memcpy(records.data(), p, num_loans * sizeof(LoanRecord));
+        p += num_loans * sizeof(LoanRecord);
+
+        StringVector statuses;
+        for (std::uint32_t i = 0; i < header.num_statuses; ++i) {
+            std::uint32_t length;
+            if (static_cast<size_t>(data + size - p) < sizeof(length)) {
+                reason = "truncated status table";
+                return false;
+            }
+            std::memcpy(&length, p, sizeof(length));
+            p += sizeof(length);
+            if (static_cast<size_t>(data + size - p) < length) {
+                reason = "truncated status table";
+                return false;
+            }
+            statuses.push_back(LCString(p, length));
+            p += length;
+        }
+
+        metrics = LoanMetrics();
+        metrics.reserve(num_loans);
+        loan_infos.resize(num_loans);
+        for (size_t i = 0; i < num_loans; ++i) {
+            const auto& record = records[i];
+            if (record.status >= statuses.size()) {
+                reason = "bad status index";
+                return false;
+            }
+
+            metrics.push_back(loan_metrics[i]);
+
+            auto& loan_info = loan_infos[i];
+            loan_info.loan_status = statuses[record.status];
+            loan_info.issue_datetime = boost::gregorian::date(record.issue_year, record.issue_month, record.issue_day);
+            loan_info.number_of_payments = record.number_of_payments;
+            loan_info.installment = record.installment;
+            loan_info.int_rate = record.int_rate;
+            loan_info.total_pymnt = record.total_pymnt;
+            loan_info.out_prncp = record.out_prncp;
+            loan_info.out_prncp_inv = record.out_prncp_inv;
+            loan_info.profit = record.profit;
+            loan_info.principal = record.principal;
+            loan_info.lost = record.lost;
+            loan_info.defaulted = record.defaulted;
+        }
+
+        counts.skipped_loans = header.skipped_loans;
+        counts.young_loans = header.young_loans;
+        counts.removed_expired_loans = header.removed_expired_loans;
+        return true;
+    }
+
+    // Writes the snapshot next to its final name and renames it, so a reader never sees half a file
+    //
+    bool save(const LoanVector& loans, const LoanInfoVector& loan_infos, const LoanMetrics& metrics, const Counts& counts,
+        LCString& reason)
+    {
+        if ((_expected.source_size == 0) && !stat_source(reason)) {
+            return false;
+        }
+        if ((_expected.source_sample_checksum == 0) && !sample_source(reason)) {
+            return false;
+        }
+        if ((_expected.source_checksum == 0) && !checksum_source(reason)) {
+            return false;
+        }
+
+        Header header = _expected;
+        header.num_loans = loans.size();
+        header.skipped_loans = counts.skipped_loans;
+        header.young_loans = counts.young_loans;
+        header.removed_expired_loans = counts.removed_expired_loans;
+
+        std::map<LCString, std::uint32_t> status_index;
+        StringVector statuses;
+        std::vector<LoanRecord> records(loan_infos.size());
+        std::vector<LoanMetric> loan_metrics(loans.size());
+
+        for (size_t i = 0; i < loan_infos.size(); ++i) {
+            const auto& loan_info = loan_infos[i];
+            auto& record = records[i];
+            std::memset(&record, 0, sizeof(record));
+
+            auto it = status_index.find(loan_info.loan_status);
+            if (it == status_index.end()) {
+                it = status_index.insert(std::make_pair(loan_info.loan_status, static_cast<std::uint32_t>(statuses.size()))).first;
+                statuses.push_back(loan_info.loan_status);
+            }
+
+            record.status = it->second;
+            record.issue_year = static_cast<std::uint16_t>(loan_info.issue_datetime.year());
+            record.issue_month = static_cast<std::uint8_t>(loan_info.issue_datetime.month());
+            record.issue_day = static_cast<std::uint8_t>(loan_info.issue_datetime.day());
+            record.number_of_payments = loan_info.number_of_payments;
+            record.defaulted = loan_info.defaulted;
+            record.installment = loan_info.installment;
+            record.int_rate = loan_info.int_rate;
+            record.total_pymnt = loan_info.total_pymnt;
+            record.out_prncp = loan_info.out_prncp;
+            record.out_prncp_inv = loan_info.out_prncp_inv;
+            record.profit = loan_info.profit;
+            record.principal = loan_info.principal;
+            record.lost = loan_info.lost;
+
+            loan_metrics[i] = metrics.get(static_cast<unsigned>(i));
+        }
+        header.num_statuses = static_cast<std::uint32_t>(statuses.size());
+
+        LCString temp_path = _snapshot_path + ".tmp";
+        {
+            std::ofstream out(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(loans.data()), loans.size() * sizeof(Loan));
+            out.write(reinterpret_cast<const char*>(loan_metrics.data()), loan_metrics.size() * sizeof(LoanMetric));
+            out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(LoanRecord));
+            for (auto& status : statuses) {
+                std::uint32_t length = static_cast<std::uint32_t>(status.size());
+                out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+                out.write(status.data(), length);
+            }
+
+            if (!out) {
+                reason = "could not write " + temp_path;
+                return false;
+            }
+        }
+
+        boost::system::error_code ec;
+        boost::filesystem::rename(temp_path, _snapshot_path, ec);
+        if (ec) {
+            reason = "could not rename " + temp_path + ": " + ec.message();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Header
+    {
+        char                            magic[8];
+        std::uint32_t                   version;
+        std::uint32_t                   header_size;
+        std::uint64_t                   schema_hash;            // layout of the records and the filters converted
+        std::uint64_t                   options_hash;           // grades, states and young_loans_in_days
+        std::uint64_t                   source_size;
+        std::int64_t                    source_mtime;
+        std::uint64_t                   source_checksum;        // all of every stats file
+        std::uint64_t                   source_sample_checksum; // the first and last sample_size bytes of every stats file
+        std::int64_t                    clock;                  // seconds since 1970 the earliest credit line ages are measured at
+        std::uint16_t                   cutoff_year;            // loans issued after the cutoff were skipped as young
+        std::uint8_t                    cutoff_month;
+        std::uint8_t                    cutoff_day;
+        std::uint32_t                   num_statuses;
+        std::uint64_t                   num_loans;
+        std::uint32_t                   skipped_loans;
+        std::uint32_t                   young_loans;
+        std::uint32_t                   removed_expired_loans;
+        std::uint32_t                   reserved;
+    };
+
+    // LoanInfo without the string and the date
+    struct LoanRecord
+    {
+        double                          installment;
+        double                          int_rate;
+        double                          total_pymnt;
+        double                          out_prncp;
+        double                          out_prncp_inv;
+        double                          profit;
+        double                          principal;
+        double                          lost;
+        std::uint32_t                   number_of_payments;
+        std::uint32_t                   defaulted;
+        std::uint32_t                   status;                 // index in the status table
+        std::uint16_t                   issue_year;
+        std::uint8_t                    issue_month;
+        std::uint8_t                    issue_day;
+    };
+
+    // FNV-1a over 8 byte words, plenty to notice a changed file
+    //
+    static std::uint64_t hash_bytes(const void* data, const size_t size, std::uint64_t hash = 0xcbf29ce484222325ull)
+    {
+        const char* p = static_cast<const char*>(data);
+        size_t i = 0;
+        for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+            std::uint64_t word;
+            std::memcpy(&word, p + i, sizeof(word));
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+        for (; i < size; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(p[i])) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    bool stat_source(LCString& reason)
+    {
+        _expected.source_size = 0;
+        _expected.source_mtime = 0;
+        for (const auto& source_path : _source_paths) {
+            boost::system::error_code ec;
+            std::uint64_t size = boost::filesystem::file_size(source_path, ec);
+            std::int64_t mtime = 0;
+            if (!ec) {
+                mtime = static_cast<std::int64_t>(boost::filesystem::last_write_time(source_path, ec));
+            }
+            if (ec) {
+                reason = source_path + ": " + ec.message();
+                return false;
+            }
+            _expected.source_size += size;
+            _expected.source_mtime = std::max(_expected.source_mtime, mtime);
+        }
+        return true;
+    }
+
+    // Hashes the name and the first and last sample_size bytes of every stats file in order, the sizes and
+    // times were compared already so this catches a file rewritten in place with the same size and time
+    //
+    bool sample_source(LCString& reason)
+    {
+        std::uint64_t checksum = hash_bytes(nullptr, 0);
+        std::vector<char> buffer(2 * sample_size);
+        for (const auto& source_path : _source_paths) {
+            std::ifstream in(source_path.c_str(), std::ios::binary);
+            in.seekg(0, std::ios::end);
+            const size_t size = static_cast<size_t>(in.tellg());
+            if (!in || (size == 0)) {
+                reason = source_path + " is empty or unreadable";
+                return false;
+            }
+
+            // A file shorter than two samples is hashed whole
+            //
+            const size_t head_size = std::min(size, sample_size);
+            const size_t tail_size = std::min(size - head_size, sample_size);
+            in.seekg(0, std::ios::beg);
+            in.read(buffer.data(), head_size);
+            in.seekg(static_cast<std::streamoff>(size - tail_size), std::ios::beg);
+            in.read(buffer.data() + head_size, tail_size);
+            if (!in) {
+                reason = "could not read " + source_path;
+                return false;
+            }
+
+            checksum = hash_bytes(source_path.data(), source_path.size(), checksum);
+            checksum = hash_bytes(buffer.data(), head_size + tail_size, checksum);
+        }
+        _expected.source_sample_checksum = checksum;
+        return true;
+    }
+
+    // Hashes the name and contents of every stats file in order, a different list of files does not match
+    //
+    bool checksum_source(LCString& reason)
+    {
+        std::uint64_t checksum = hash_bytes(nullptr, 0);
+        for (const auto& source_path : _source_paths) {
+            if (boost::filesystem::file_size(source_path) == 0) {
+                reason = source_path + " is empty";
+                return false;
+            }
+
+            boost::interprocess::file_mapping file(source_path.c_str(), boost::interprocess::read_only);
+            boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+            checksum = hash_bytes(source_path.data(), source_path.size(), checksum);
+            checksum = hash_bytes(region.get_address(), region.get_size(), checksum);
+        }
+        _expected.source_checksum = checksum;
+        return true;
+    }
+
+    LCString                                    _snapshot_path;
+    StringVector                                _source_paths;
+    Header                                      _expected;
+};
+
+};
+
+#endif // __LC_LOAN_SNAPSHOT_HPP__
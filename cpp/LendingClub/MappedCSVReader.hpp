@@ -0,0 +1,346 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_MAPPED_CSV_READER_HPP__
+#define __LC_MAPPED_CSV_READER_HPP__
+
+#include <cstring>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "Types.hpp"
+#include "csv.h"
+
+namespace lc
+{
+
+//
+// Reads a CSV file the way io::CSVReader<N, io::trim_chars<' ', '\t'>, io::double_quote_escape<',', '\"'>,
+// io::throw_on_overflow, io::single_line_comment<'N','L','\0'>> does, without copying it.
+//
+// The file is mapped copy on write and tokenized in place, each row hands out LCStringRef fields
+// pointing into the mapping, so no cell is ever copied or allocated. Quoted fields are unescaped in
+// place, which only touches the (private) pages of the rows that have doubled quotes. The fields
+// of a row are only valid until the next read_row.
+//
+// Unlike io::CSVReader a quoted field may contain a newline. Lines starting with N or L (the notes
+// LendingClub puts around the loans) and empty lines are skipped.
+//
+// After the header the rows can be split into ranges that are read concurrently, see split().
+//
+class MappedCSVReader
+{
+public:
+    // A run of whole rows, read front to back
+    struct Range
+    {
+        char*                           next;
+        char*                           end;
+        unsigned                        line;           // line number of next, for errors
+        size_t                          num_rows;       // rows read so far
+    };
+
+    MappedCSVReader(const LCString& file_name) :
+        _file_name(file_name),
+        _begin(nullptr),
+        _end(nullptr)
+    {
+        _rest.next = nullptr;
+        _rest.end = nullptr;
+        _rest.line = 1;
+        _rest.num_rows = 0;
+
+        if (boost::filesystem::file_size(_file_name) == 0) {
+            throw_error<io::error::header_missing>();
+        }
+
+        _file = boost::interprocess::file_mapping(_file_name.c_str(), boost::interprocess::read_only);
+        _region = boost::interprocess::mapped_region(_file, boost::interprocess::copy_on_write);
+        _region.advise(boost::interprocess::mapped_region::advice_sequential);
+
+        _begin = static_cast<char*>(_region.get_address());
+        _end = _begin + _region.get_size();
+        _rest.next = _begin;
+        _rest.end = _end;
+    }
+
+    // Finds the given columns in the header, read_row fills in its fields in this order
+    //
+    void read_header(const StringVector& column_names)
+    {
+        skip_comments(_rest);
+        if (_rest.next == _rest.end) {
+            throw_error<io::error::header_missing>();
+        }
+
+        _columns.clear();
+        std::vector<bool> found(column_names.size(), false);
+        bool end_of_row = false;
+
+        while (!end_of_row) {
+            LCStringRef name = next_field(_rest, end_of_row);
+            int column = -1;
+            for (size_t i = 0; i < column_names.size(); ++i) {
+                if (name == column_names[i]) {
+                    if (found[i]) {
+                        throw_column_error<io::error::duplicated_column_in_header>(column_names[i]);
+                    }
+                    found[i] = true;
+                    column = static_cast<int>(i);
+                    break;
+                }
+            }
+            _columns.push_back(column);
+        }
+
+        for (size_t i = 0; i < column_names.size(); ++i) {
+            if (!found[i]) {
+                throw_column_error<io::error::missing_column_in_header>(column_names[i]);
+            }
+        }
+    }
+
+    // Splits the rows not read yet into num_ranges ranges of about the same number of bytes, each
+    // starting on a row. Finding the row boundaries takes one pass over the file that only looks for
+    // quotes and newlines, a newline inside a quoted field does not end a row. Some ranges may be empty.
+    //
+    std::vector<Range> split(const unsigned num_ranges) const
+    {
+        std::vector<Range> ranges;
+        Range range = _rest;
+        range.num_rows = 0;
+
+        const size_t size = static_cast<size_t>(_rest.end - _rest.next);
+        char* p = _rest.next;
+        unsigned line = _rest.line;
+        bool quoted = false;
+        bool row_start = true;
+
+        for (unsigned i = 1; i < num_ranges; ++i) {
+            const char* target = _rest.next + size * i / num_ranges;
+            while (p != _rest.end) {
+                if (row_start) {
+                    // Comment lines are not rows and may have stray quotes
+                    //
+                    while ((p != _rest.end) && ((*p == 'N') || (*p == 'L'))) {
+                        while ((p != _rest.end) && (*p != '\n')) {
+                            ++p;
+                        }
+                        if (p != _rest.end) {
+                            ++p;
+                            ++line;
+                        }
+                    }
+                    if ((p >= target) || (p == _rest.end)) {
+                        break;
+                    }
+                    row_start = false;
+                }
+
+                char c = *p++;
+                if (c == '"') {
+                    quoted = !quoted;
+                } else if (c == '\n') {
+                    ++line;
+                    row_start = !quoted;
+                }
+            }
+
+            range.end = p;
+            ranges.push_back(range);
+            range.next = p;
+            range.line = line;
+        }
+
+        range.end = _rest.end;
+        ranges.push_back(range);
+        return ranges;
+    }
+
+    // Fills in fields (one per read_header column), returns false at the end of the file
+    //
+    bool read_row(LCStringRef* fields)
+    {
+        return read_row(_rest, fields);
+    }
+
+    // Fills in fields from the next row of range, returns false at the end of the range. Ranges from
+    // split() can be read concurrently.
+    //
+    bool read_row(Range& range, LCStringRef* fields) const
+    {
+        skip_comments(range);
+        if (range.next == range.end) {
+            return false;
+        }
+
+        const unsigned line = range.line;
+        bool end_of_row = false;
+        for (size_t i = 0; i < _columns.size(); ++i) {
+            if (end_of_row) {
+                throw_line_error<io::error::too_few_columns>(line);
+            }
+            LCStringRef field = next_field(range, end_of_row);
+            if (_columns[i] >= 0) {
+                fields[_columns[i]] = field;
+            }
+        }
+        if (!end_of_row) {
+            throw_line_error<io::error::too_many_columns>(line);
+        }
+
+        ++range.num_rows;
+        return true;
+    }
+
+    size_t get_size() const
+    {
+        return static_cast<size_t>(_end - _begin);
+    }
+
+    // Rows read without a range
+    size_t get_num_rows() const
+    {
+        return _rest.num_rows;
+    }
+
+private:
+    static bool is_trim_char(const char c)
+    {
+        return (c == ' ') || (c == '\t');
+    }
+
+    static void skip_line(Range& range)
+    {
+        while ((range.next != range.end) && (*range.next != '\n')) {
+            ++range.next;
+        }
+        if (range.next != range.end) {
+            ++range.next;
+            ++range.line;
+        }
+    }
+
+    static void skip_comments(Range& range)
+    {
+        while (range.next != range.end) {
+            char c = *range.next;
+            bool empty_line = (c == '\n') || ((c == '\r') && ((range.next + 1 == range.end) || (range.next[1] == '\n')));
+            if ((c != 'N') && (c != 'L') && !empty_line) {
+                break;
+            }
+            skip_line(range);
+        }
+    }
+
+    // Returns the field at range.next and moves past its separator, end_of_row is set when the field ends the row
+    //
+    LCStringRef next_field(Range& range, bool& end_of_row) const
+    {
+        char* begin = range.next;
+        char* p = range.next;
+
+        while ((p != range.end) && (*p != ',') && (*p != '\n')) {
+            if (*p != '"') {
+                ++p;
+                continue;
+            }
+
+            // A quoted run, a doubled quote does not close it
+            //
+            do {
+                ++p;
+                while ((p != range.end) && (*p != '"')) {
+                    range.line += (*p == '\n');
+                    ++p;
+                }
+                if (p == range.end) {
+                    throw_line_error<io::error::escaped_string_not_closed>(range.line);
+                }
+                ++p;
+            } while ((p != range.end) && (*p == '"'));
+        }
+
+        char* end = p;
+        end_of_row = (p == range.end) || (*p == '\n');
+        if (p != range.end) {
+            range.line += (*p == '\n');
+            ++p;
+        }
+        range.next = p;
+
+        if (end_of_row && (end != begin) && (end[-1] == '\r')) {
+            --end;
+        }
+
+        while ((begin != end) && is_trim_char(*begin)) {
+            ++begin;
+        }
+        while ((begin != end) && is_trim_char(end[-1])) {
+            --end;
+        }
+
+        if ((end - begin >= 2) && (*begin == '"') && (end[-1] == '"')) {
+            ++begin;
+            --end;
+            char* out = begin;
+            for (char* in = begin; in != end; ++in) {
+                if ((*in == '"') && (in + 1 != end) && (in[1] == '"')) {
+                    continue;
+                }
+                *out++ = *in;
+            }
+            end = out;
+        }
+
+        return LCStringRef(begin, end - begin);
+    }
+
+    template<class Error>
+    void throw_error() const
+    {
+        Error error;
+        error.set_file_name(_file_name.c_str());
+        throw error;
+    }
+
+    template<class Error>
+    void throw_line_error(const unsigned line) const
+    {
+        Error error;
+        error.set_file_name(_file_name.c_str());
+        error.set_file_line(static_cast<int>(line));
+        throw error;
+    }
+
+    template<class Error>
+    void throw_column_error(const LCString& column_name) const
+    {
+        Error error;
+        error.set_file_name(_file_name.c_str());
+        error.set_column_name(column_name.c_str());
+        throw error;
+    }
+
+    const LCString                              _file_name;
+    boost::interprocess::file_mapping           _file;
+    boost::interprocess::mapped_region          _region;
+    char*                                       _begin;
+    char*                                       _end;
+    Range                                       _rest;        // the rows read_row(fields) has not read yet
+    std::vector<int>                            _columns;     // index into the read_header names, -1 when not read
+};
+
+};
+
+#endif // __LC_MAPPED_CSV_READER_HPP__
@@ -0,0 +1,128 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "NumaPlacement.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+
+using namespace lc;
+
+const int NumaPlacement::unknown_node;
+
+namespace
+{
+
+// Pages looked up per move_pages call
+const size_t pages_per_query = 1024;
+
+};
+
+bool NumaPlacement::parse_mode(const LCString& name, Mode& mode)
+{
+    if (name == "none") {
+        mode = Mode::NONE;
+    } else if (name == "replicate") {
+        mode = Mode::REPLICATE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+LCString NumaPlacement::get_name(const Mode mode)
+{
+    switch (mode) {
+    case Mode::NONE:      return "none";
+    case Mode::REPLICATE: return "replicate";
+    }
+    return "unknown";
+}
+
+std::map<int, size_t> NumaPlacement::count_pages(const MemoryRegions& regions)
+{
+    std::map<int, size_t> pages;
+
+#if defined(__linux__) && defined(SYS_move_pages)
+    const std::uintptr_t page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    std::vector<void*> addresses;
+    for (const auto& region : regions) {
+        if (region.second == 0) {
+            continue;
+        }
+        std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(region.first) & ~(page_size - 1);
+        std::uintptr_t end = reinterpret_cast<std::uintptr_t>(region.first) + region.second;
+        for (std::uintptr_t page = begin; page < end; page += page_size) {
+            addresses.push_back(reinterpret_cast<void*>(page));
+        }
+    }
+
+    // With no target nodes move_pages only reports the node of every page, or a negative errno
+    //
+    std::vector<int> status(pages_per_query);
+    for (size_t first = 0; first < addresses.size(); first += pages_per_query) {
+        size_t count = std::min(pages_per_query, addresses.size() - first);
+        if (syscall(SYS_move_pages, 0, count, &addresses[first], nullptr, &status[0], 0) != 0) {
+            pages[unknown_node] += count;
+            continue;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            ++pages[(status[i] >= 0) ? status[i] : unknown_node];
+        }
+    }
+#else
+    for (const auto& region : regions) {
+        pages[unknown_node] += (region.second + 4095) / 4096;
+    }
+#endif
+
+    return pages;
+}
+
+LCString NumaPlacement::describe_pages(const std::map<int, size_t>& pages, const int node)
+{
+    // Without a node of its own, where the pages are
+    //
+    if (node == unknown_node) {
+        LCString description;
+        for (const auto& node_pages : pages) {
+            description += (description.empty() ? "" : ", ") + boost::lexical_cast<LCString>(node_pages.second) +
+                ((node_pages.first == unknown_node) ? LCString(" pages not placed") : (" pages on node " + boost::lexical_cast<LCString>(node_pages.first)));
+        }
+        return description.empty() ? LCString("no pages") : description;
+    }
+
+    size_t total = 0;
+    size_t local = 0;
+    size_t remote = 0;
+    size_t unknown = 0;
+    for (const auto& node_pages : pages) {
+        total += node_pages.second;
+        if (node_pages.first == node) {
+            local += node_pages.second;
+        } else if (node_pages.first == unknown_node) {
+            unknown += node_pages.second;
+        } else {
+            remote += node_pages.second;
+        }
+    }
+
+    return boost::lexical_cast<LCString>(total) + " pages, " + boost::lexical_cast<LCString>(local) + " on node " +
+        boost::lexical_cast<LCString>(node) + ", " + boost::lexical_cast<LCString>(remote) + " on other nodes, " +
+        boost::lexical_cast<LCString>(unknown) + " not placed";
+}
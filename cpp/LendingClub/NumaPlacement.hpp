@@ -0,0 +1,51 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_NUMA_PLACEMENT_HPP__
+#define __LC_NUMA_PLACEMENT_HPP__
+
+#include <cstdint>
+#include <map>
+#include "Types.hpp"
+
+namespace lc
+{
+
+//
+// Where the loan data the workers scan lives, selected by the "numa" argument:
+//   none      - one copy, placed wherever the loading thread touched it first
+//   replicate - a copy per NUMA node with test threads, each thread scans its own node's copy
+//
+// The pages of a copy are looked up with move_pages(2), so no libnuma is needed. Elsewhere than on
+// Linux the node of a page is never known and there is nothing to replicate.
+//
+class NumaPlacement
+{
+public:
+    enum class Mode : std::int8_t { NONE = 0, REPLICATE = 1 };
+
+    // Node of pages that are not placed yet or whose node the system cannot tell
+    static const int unknown_node = -1;
+
+    static bool parse_mode(const LCString& name, Mode& mode);
+    static LCString get_name(const Mode mode);
+
+    // Number of pages of the regions on each node
+    static std::map<int, size_t> count_pages(const MemoryRegions& regions);
+
+    // 2048 pages, 2048 on node 1, 0 on other nodes, 0 not placed, or just the pages of each node when node is unknown_node
+    static LCString describe_pages(const std::map<int, size_t>& pages, const int node);
+};
+
+};
+
+#endif // __LC_NUMA_PLACEMENT_HPP__
@@ -0,0 +1,113 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_PERFECT_HASH_MAP_HPP__
+#define __LC_PERFECT_HASH_MAP_HPP__
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+#include "Types.hpp"
+
+namespace lc
+{
+
+//
+// Read only map from the category names of a column (grades, states, loan purposes) to their filter
+// values, looked up straight from a CSV field.
+//
+// build() picks a table size and hash seed under which no two names collide, so a lookup hashes the
+// field once and compares it against the one name in its slot, no probing and no string is built.
+//
+class PerfectHashMap
+{
+public:
+    PerfectHashMap() : _mask(0), _seed(0) {}
+
+    void build(const std::map<LCString, FilterValue>& entries)
+    {
+        for (size_t size = 4; ; size *= 2) {
+            if (size < 2 * entries.size()) {
+                continue;
+            }
+            for (std::uint64_t seed = 0; seed < 64; ++seed) {
+                if (try_build(entries, size, seed)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    // Returns true and sets value when key is one of the names
+    //
+    inline bool find(const LCStringRef& key, FilterValue& value) const
+    {
+        if (_slots.empty()) {
+            return false;
+        }
+
+        const Slot& slot = _slots[hash(key.data(), key.size(), _seed) & _mask];
+        if (!slot.used || (slot.key.size() != key.size()) || (std::memcmp(slot.key.data(), key.data(), key.size()) != 0)) {
+            return false;
+        }
+        value = slot.value;
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        Slot() : used(false), value(0) {}
+
+        bool                            used;
+        LCString                        key;
+        FilterValue                     value;
+    };
+
+    // FNV-1a
+    static inline std::uint64_t hash(const char* data, const size_t size, const std::uint64_t seed)
+    {
+        std::uint64_t h = 0xcbf29ce484222325ull ^ (seed * 0x9e3779b97f4a7c15ull);
+        for (size_t i = 0; i < size; ++i) {
+            h = (h ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ull;
+        }
+        return h ^ (h >> 29);
+    }
+
+    bool try_build(const std::map<LCString, FilterValue>& entries, const size_t size, const std::uint64_t seed)
+    {
+        std::vector<Slot> slots(size);
+        for (const auto& entry : entries) {
+            Slot& slot = slots[hash(entry.first.data(), entry.first.size(), seed) & (size - 1)];
+            if (slot.used) {
+                return false;
+            }
+            slot.used = true;
+            slot.key = entry.first;
+            slot.value = entry.second;
+        }
+
+        _slots.swap(slots);
+        _mask = size - 1;
+        _seed = seed;
+        return true;
+    }
+
+    std::vector<Slot>                           _slots;
+    size_t                                      _mask;
+    std::uint64_t                               _seed;
+};
+
+};
+
+#endif // __LC_PERFECT_HASH_MAP_HPP__
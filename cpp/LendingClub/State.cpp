@@ -18,5 +18,6 @@ const LCString State::sqlite_type = "INT";
 const LCString State::csv_name = "addr_state";
 const LCString State::name = "State";
 std::map<LCString, FilterValue> State::_conversion_table;
+PerfectHashMap State::_lookup;
 const FilterValueVector* State::options = nullptr;
 const Filter::Relation State::relation = Filter::Relation::MASK;
@@ -18,6 +18,7 @@ Created on July 28, 2014
 #include "Filter.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
+#include "PerfectHashMap.hpp"
 
 namespace lc
 {
@@ -105,6 +106,7 @@ public:
                 }
             }
             
+            _lookup.build(_conversion_table);
             options = new FilterValueVector(power_bitset(state_bitmap));
         }       
     }
@@ -127,11 +129,12 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
-        auto it = _conversion_table.find(raw_data);
-        assert(it != _conversion_table.end());
-        return (it->second);
+        FilterValue value = 0;
+        bool found = _lookup.find(raw_data, value);
+        assert(found);
+        return value;
     }
 
     virtual const LCString get_string_value() const
@@ -163,6 +166,7 @@ public:
 
 private:
     static std::map<LCString, FilterValue>   _conversion_table;
+    static PerfectHashMap                    _lookup;
 };
 
 };
@@ -12,6 +12,7 @@ Created on July 27, 2014
 #ifndef __LC_TYPES_HPP__
 #define __LC_TYPES_HPP__
 
+#include <cstdint>
 #include <map>
 
 #ifdef FB_FOLLY_STRING
@@ -42,8 +43,27 @@ namespace lc
 };
 #endif
 
+// A field of a CSV row, points into the file instead of owning a copy
+//
+#include <boost/utility/string_ref.hpp>
+namespace lc
+{
+    typedef boost::string_ref LCStringRef;
+};
+
+// Blocks of memory, to look up which NUMA node their pages are on
+//
+#include <cstddef>
+#include <utility>
+#include <vector>
+namespace lc
+{
+    typedef std::vector<std::pair<const void*, size_t>> MemoryRegions;
+};
+
 #ifdef FB_FOLLY_VECTOR
 #include <folly/FBVector.h>
+#include "HugePages.hpp"
 namespace lc
 {
     typedef unsigned long long FilterValue;
@@ -56,20 +76,21 @@ namespace lc
 
     struct Loan;
     struct LoanInfo;
-    typedef folly::fbvector<Loan> LoanVector;
-    typedef folly::fbvector<LoanInfo> LoanInfoVector;
+    typedef folly::fbvector<Loan, HugePageAllocator<Loan>> LoanVector;
+    typedef folly::fbvector<LoanInfo, HugePageAllocator<LoanInfo>> LoanInfoVector;
 
     typedef unsigned long long LoanValue;
     typedef folly::fbvector<LoanValue> LoanValueVector;
 
     typedef folly::fbvector<LCString> StringVector;
 
-    struct LoanReturn;
-    typedef folly::fbvector<std::pair<LoanReturn, FilterPtrVector>> PopulationType;
+    // Index of the option a filter is set to, a genome has one for each filter
+    typedef std::uint16_t Gene;
 };
 #else
 
 #include <vector>
+#include "HugePages.hpp"
 namespace lc
 {
     typedef unsigned long long FilterValue;
@@ -82,16 +103,16 @@ namespace lc
 
     struct Loan;
     struct LoanInfo;
-    typedef std::vector<Loan> LoanVector;
-    typedef std::vector<LoanInfo> LoanInfoVector;
+    typedef std::vector<Loan, HugePageAllocator<Loan>> LoanVector;
+    typedef std::vector<LoanInfo, HugePageAllocator<LoanInfo>> LoanInfoVector;
 
     typedef unsigned long long LoanValue;
     typedef std::vector<LoanValue> LoanValueVector;
 
     typedef std::vector<LCString> StringVector;
 
-    struct LoanReturn;
-    typedef std::vector<std::pair<LoanReturn, FilterPtrVector>> PopulationType;
+    // Index of the option a filter is set to, a genome has one for each filter
+    typedef std::uint16_t Gene;
 };
 #endif
 
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include "Utilities.hpp"
 
 using namespace lc;
@@ -29,3 +32,64 @@ unsigned lc::randint(const unsigned a, const unsigned b)
 {
     return (rand() % (b - a + 1) + a);
 }
+
+// Matches name against a pattern of * (any run of characters) and ? (any one character)
+static bool wildcard_match(const char* pattern, const char* name)
+{
+    for (; *pattern != '\0'; ++pattern, ++name) {
+        if (*pattern == '*') {
+            for (const char* rest = name; ; ++rest) {
+                if (wildcard_match(pattern + 1, rest)) {
+                    return true;
+                }
+                if (*rest == '\0') {
+                    return false;
+                }
+            }
+        }
+        if ((*name == '\0') || ((*pattern != '?') && (*pattern != *name))) {
+            return false;
+        }
+    }
+    return (*name == '\0');
+}
+
+StringVector lc::expand_paths(const LCString& paths)
+{
+    StringVector patterns;
+    boost::split(patterns, paths, boost::is_any_of(","));
+
+    StringVector result;
+    for (auto pattern : patterns) {
+        boost::trim(pattern);
+        if (pattern.empty()) {
+            continue;
+        }
+
+        boost::filesystem::path pattern_path(pattern);
+        LCString file_pattern = pattern_path.filename().string();
+        if (file_pattern.find_first_of("*?") == LCString::npos) {
+            result.push_back(pattern);
+            continue;
+        }
+
+        // Only the file name may have wildcards, the matches are sorted so the load order is the same every run
+        //
+        boost::filesystem::path directory = pattern_path.parent_path();
+        StringVector matches;
+        boost::system::error_code ec;
+        for (boost::filesystem::directory_iterator it(directory.empty() ? "." : directory, ec), end; !ec && (it != end); it.increment(ec)) {
+            LCString name = it->path().filename().string();
+            if (boost::filesystem::is_regular_file(it->path()) && wildcard_match(file_pattern.c_str(), name.c_str())) {
+                matches.push_back((directory / name).string());
+            }
+        }
+
+        if (matches.empty()) {
+            result.push_back(pattern);
+        }
+        std::sort(matches.begin(), matches.end());
+        result.insert(result.end(), matches.begin(), matches.end());
+    }
+    return result;
+}
@@ -14,9 +14,14 @@ Created on July 28, 2014
 #define __LC_UTILITIES_HPP__
 
 #include <cassert>
+#include <cstdint>
 #include <map>
 #include "Types.hpp"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace lc
 {
 
@@ -26,6 +31,48 @@ LCString map_to_str(const std::map<LCString, LCString>& m);
 // Returns random number a <= N <= b
 unsigned randint(const unsigned a, const unsigned b);
 
+// Splits a comma separated list of paths and expands * and ? in their file names, a pattern that
+// matches nothing is kept as is so the caller reports it as missing
+StringVector expand_paths(const LCString& paths);
+
+// Returns the index of the lowest set bit, word must not be 0
+inline unsigned count_trailing_zeros(const std::uint64_t word)
+{
+    assert(word != 0);
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#elif defined(_MSC_VER)
+    unsigned long idx = 0;
+    if (static_cast<std::uint32_t>(word) != 0) {
+        _BitScanForward(&idx, static_cast<std::uint32_t>(word));
+        return idx;
+    }
+    _BitScanForward(&idx, static_cast<std::uint32_t>(word >> 32));
+    return idx + 32;
+#else
+    unsigned idx = 0;
+    for (std::uint64_t w = word; (w & 1) == 0; w >>= 1) {
+        ++idx;
+    }
+    return idx;
+#endif
+}
+
+// Returns the number of set bits
+inline unsigned population_count(const std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<unsigned>(__popcnt64(word));
+#else
+    std::uint64_t w = word - ((word >> 1) & 0x5555555555555555ull);
+    w = (w & 0x3333333333333333ull) + ((w >> 2) & 0x3333333333333333ull);
+    w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<unsigned>((w * 0x0101010101010101ull) >> 56);
+#endif
+}
+
 };
 
 #endif // __LC_UTILITIES_HPP__
\ No newline at end of file
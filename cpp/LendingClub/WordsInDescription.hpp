@@ -14,6 +14,7 @@ Created on July 28, 2014
 #define __LC_WORDS_IN_DESCRIPTION_HPP__
 
 #include <algorithm>
+#include <cstring>
 #include "Filter.hpp"
 #include "Loan.hpp"
 #include "Utilities.hpp"
@@ -56,12 +57,74 @@ public:
         set_current(0);
     }
 
-    virtual FilterValue convert(const LCString& raw_data) const
+    virtual FilterValue convert(const LCStringRef& raw_data) const
     {
-        LCString data = raw_data;
-        std::unique(data.begin(), data.end(), BothAreSpaces<' '>);
-        std::unique(data.begin(), data.end(), BothAreSpaces<'\t'>);
-        return std::count(data.begin(), data.end(), ' ');
+        return count_words(raw_data.data(), raw_data.size());
+    }
+
+    // Counts what converting a copy of the description used to count, without the copy. That ran
+    // std::unique over the copy for space runs and then for tab runs without erasing what std::unique
+    // leaves past its new end, and counted the spaces of the whole copy. So with the description D of
+    // n characters, K its space runs collapsed (n1 characters) and A = K followed by D[n1, n), the
+    // count is the spaces of A plus the spaces of A[n - T, n), T being the number of tabs right after
+    // a tab in A.
+    //
+    static FilterValue count_words(const char* desc, const size_t n)
+    {
+        // Without tabs A is left as is, K has one space per space run of D
+        //
+        if ((n > 0) && (std::memchr(desc, '\t', n) == nullptr)) {
+            size_t space_runs = (desc[0] == ' ');
+            size_t all_spaces = space_runs;
+            for (size_t i = 1; i < n; ++i) {
+                all_spaces += (desc[i] == ' ');
+                space_runs += (desc[i] == ' ') & (desc[i - 1] != ' ');
+            }
+            return space_runs + std::count(desc + n - (all_spaces - space_runs), desc + n, ' ');
+        }
+
+        size_t n1 = 0;
+        size_t spaces = 0;
+        size_t tabs = 0;
+        char last = '\0';
+
+        for (size_t i = 0; i < n; ++i) {
+            char c = desc[i];
+            if ((n1 > 0) && BothAreSpaces<' '>(last, c)) {
+                continue;
+            }
+            tabs += ((n1 > 0) && BothAreSpaces<'\t'>(last, c));
+            spaces += (c == ' ');
+            last = c;
+            ++n1;
+        }
+
+        for (size_t i = n1; i < n; ++i) {
+            tabs += BothAreSpaces<'\t'>(last, desc[i]);
+            spaces += (desc[i] == ' ');
+            last = desc[i];
+        }
+
+        const size_t n2 = n - tabs;
+        for (size_t i = std::max(n1, n2); i < n; ++i) {
+            spaces += (desc[i] == ' ');
+        }
+
+        // More tabs removed than spaces, the tail reaches back into K
+        //
+        if (n2 < n1) {
+            size_t k = 0;
+            for (size_t i = 0; i < n; ++i) {
+                char c = desc[i];
+                if ((k > 0) && BothAreSpaces<' '>(last, c)) {
+                    continue;
+                }
+                spaces += ((k >= n2) && (c == ' '));
+                last = c;
+                ++k;
+            }
+        }
+        return spaces;
     }
 
     virtual const LCString get_string_value() const
@@ -0,0 +1,351 @@
+/*
+Created on October 17, 2026
+
+@author:     Gregory Czajkowski
+
+@copyright:  2013 Freedom. All rights reserved.
+
+@license:    Licensed under the Apache License 2.0 http://www.apache.org/licenses/LICENSE-2.0
+
+@contact:    gregczajkowski at yahoo.com
+*/
+
+#ifndef __LC_WORK_STEALING_POOL_HPP__
+#define __LC_WORK_STEALING_POOL_HPP__
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <iomanip>
+#include <iostream>
+#include <condition_variable>
+#include "CpuTopology.hpp"
+
+namespace lc
+{
+
+//
+// Thread pool running parallel loops of tasks numbered [0, num_tasks).
+//
+// The calling thread is worker 0: run() pushes every task on its deque, wakes the other workers and
+// executes tasks itself until all are done. Idle workers steal from the top of the other deques
+// (Chase-Lev, lock free), so one expensive task does not hold the others back. A worker finding no
+// work spins for a while before parking on a condition variable, back to back run() calls find it
+// still spinning and do not pay for a wake up.
+//
+// Given the cpu of every worker, each worker thread pins itself to its cpu before taking any work.
+// Worker 0 is the caller's thread and is left as it is.
+//
+class WorkStealingPool
+{
+public:
+    // Maximum number of tasks queued per worker, run() executes any extra task right away
+    static const unsigned deque_capacity = 4096;
+
+    // Number of empty polls of the deques before an idle worker parks
+    static const unsigned spin_limit = 1024;
+
+    WorkStealingPool(const unsigned num_workers, const std::vector<int>& worker_cpus = std::vector<int>()) :
+        _context(nullptr),
+        _invoke(nullptr),
+        _pending(0),
+        _epoch(0),
+        _num_parked(0),
+        _stop(false)
+    {
+        for (unsigned i = 0; i < std::max(1u, num_workers); ++i) {
+            _workers.push_back(std::unique_ptr<Worker>(new Worker));
+            _workers.back()->cpu = (i < worker_cpus.size()) ? worker_cpus[i] : -1;
+        }
+
+        for (unsigned i = 1; i < _workers.size(); ++i) {
+            _workers[i]->thread = std::thread(&WorkStealingPool::work_function, this, i);
+        }
+    }
+
+    ~WorkStealingPool()
+    {
+        stop();
+    }
+
+    unsigned num_workers() const
+    {
+        return static_cast<unsigned>(_workers.size());
+    }
+
+    // Calls function(worker_idx, task_idx) for every task_idx in [0, num_tasks) and returns once all of
+    // them have finished. Must only be called from the thread that created the pool.
+    //
+    template<typename Function>
+    void run(const unsigned num_tasks, Function& function)
+    {
+        if (num_tasks == 0) {
+            return;
+        }
+
+        _context = &function;
+        _invoke = &invoke<Function>;
+        _pending.store(num_tasks, std::memory_order_relaxed);
+
+        // Queue the tasks from the last one down so the owner pops task 0 first, as many as fit
+        //
+        auto& self = *(_workers[0]);
+        unsigned num_unqueued = num_tasks;
+        while ((num_unqueued > 0) && self.deque.push(num_unqueued - 1)) {
+            --num_unqueued;
+        }
+
+        {
+            std::unique_lock<std::mutex> l(_mutex);
+            ++_epoch;
+            if (_num_parked > 0) {
+                _cv.notify_all();
+            }
+        }
+
+        // The tasks that did not fit run here, the workers are awake and steal the queued ones meanwhile
+        //
+        while (num_unqueued > 0) {
+            execute(0, --num_unqueued);
+        }
+
+        auto idle_start = std::chrono::steady_clock::now();
+        bool idle = false;
+        while (_pending.load(std::memory_order_acquire) != 0) {
+            if (try_execute(0)) {
+                if (idle) {
+                    self.idle += std::chrono::steady_clock::now() - idle_start;
+                    idle = false;
+                }
+            } else if (!idle) {
+                idle_start = std::chrono::steady_clock::now();
+                idle = true;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        if (idle) {
+            self.idle += std::chrono::steady_clock::now() - idle_start;
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::unique_lock<std::mutex> l(_mutex);
+            if (_stop) {
+                return;
+            }
+            _stop = true;
+            _cv.notify_all();
+        }
+
+        for (unsigned i = 1; i < _workers.size(); ++i) {
+            _workers[i]->thread.join();
+        }
+    }
+
+    void print_stats() const
+    {
+        for (unsigned i = 0; i < _workers.size(); ++i) {
+            auto& worker = *(_workers[i]);
+            std::cout << "Worker[" << i << "] " << worker.tasks << " tasks, " << worker.steals << " steals, "
+                << std::setprecision(4) << worker.idle.count() << " sec idle\n";
+        }
+    }
+
+private:
+    // Padding between the data the workers write so two of them never share a cache line
+    static const std::size_t cache_line_size = 64;
+
+    //
+    // Chase-Lev deque of task numbers, the owner pushes and pops at the bottom, thieves take from the top.
+    // The capacity is fixed so a thief never reads a buffer that is being replaced.
+    //
+    class Deque
+    {
+    public:
+        Deque() : _top(0), _bottom(0), _tasks(new std::atomic<unsigned>[deque_capacity]) {}
+
+        bool push(const unsigned task)
+        {
+            std::int64_t b = _bottom.load(std::memory_order_relaxed);
+            std::int64_t t = _top.load(std::memory_order_acquire);
+            if (b - t >= static_cast<std::int64_t>(deque_capacity)) {
+                return false;
+            }
+
+            // A release store rather than a fence, so ThreadSanitizer sees the task and everything run()
+            // wrote before it published to the thief that reads _bottom
+            //
+            _tasks[b % deque_capacity].store(task, std::memory_order_relaxed);
+            _bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(unsigned& task)
+        {
+            std::int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+            _bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t t = _top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+
+            task = _tasks[b % deque_capacity].load(std::memory_order_relaxed);
+            if (t == b) {
+                // Last task, race the thieves for it
+                bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                _bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        bool steal(unsigned& task)
+        {
+            std::int64_t t = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t b = _bottom.load(std::memory_order_acquire);
+
+            if (t >= b) {
+                return false;
+            }
+
+            task = _tasks[t % deque_capacity].load(std::memory_order_relaxed);
+            return _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::int64_t>                   _top;
+        char                                        _padding[cache_line_size];     // keep the thieves off the owner's line
+        std::atomic<std::int64_t>                   _bottom;
+        std::unique_ptr<std::atomic<unsigned>[]>    _tasks;
+    };
+
+    // Each worker is allocated on its own so the stats written by one do not share lines with another
+    //
+    struct Worker
+    {
+        Worker() : cpu(-1), tasks(0), steals(0), idle(0) {}
+
+        Deque                                       deque;
+        std::thread                                 thread;
+        int                                         cpu;            // -1 when not pinned
+        unsigned long long                          tasks;
+        unsigned long long                          steals;
+        std::chrono::duration<double>               idle;
+        char                                        padding[cache_line_size];
+    };
+
+    template<typename Function>
+    static void invoke(void* context, const unsigned worker_idx, const unsigned task)
+    {
+        (*static_cast<Function*>(context))(worker_idx, task);
+    }
+
+    void execute(const unsigned worker_idx, const unsigned task)
+    {
+        _invoke(_context, worker_idx, task);
+        ++_workers[worker_idx]->tasks;
+        _pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    bool try_execute(const unsigned worker_idx)
+    {
+        unsigned task;
+        auto& worker = *(_workers[worker_idx]);
+
+        if (worker.deque.pop(task)) {
+            execute(worker_idx, task);
+            return true;
+        }
+
+        for (unsigned i = 1; i < _workers.size(); ++i) {
+            unsigned victim = (worker_idx + i) % _workers.size();
+            if (_workers[victim]->deque.steal(task)) {
+                ++worker.steals;
+                execute(worker_idx, task);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work_function(const unsigned worker_idx)
+    {
+        auto& worker = *(_workers[worker_idx]);
+        if (worker.cpu >= 0) {
+            CpuTopology::pin_current_thread(worker.cpu);
+        }
+
+        unsigned long long seen_epoch = 0;
+        unsigned spins = 0;
+        bool idle = false;
+        auto idle_start = std::chrono::steady_clock::now();
+
+        while (true) {
+            if (try_execute(worker_idx)) {
+                if (idle) {
+                    worker.idle += std::chrono::steady_clock::now() - idle_start;
+                    idle = false;
+                }
+                spins = 0;
+                continue;
+            }
+
+            if (!idle) {
+                idle_start = std::chrono::steady_clock::now();
+                idle = true;
+            }
+
+            if (++spins < spin_limit) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Nothing showed up for a while, sleep until the next run() or stop()
+            //
+            std::unique_lock<std::mutex> l(_mutex);
+            ++_num_parked;
+            _cv.wait(l, [this, seen_epoch]() {
+                return (_epoch != seen_epoch) || _stop;
+            });
+            --_num_parked;
+            seen_epoch = _epoch;
+            spins = 0;
+
+            if (_stop) {
+                break;
+            }
+        }
+
+        if (idle) {
+            worker.idle += std::chrono::steady_clock::now() - idle_start;
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>>        _workers;
+    void*                                       _context;
+    void                                        (*_invoke)(void*, const unsigned, const unsigned);
+    std::atomic<unsigned>                       _pending;
+    std::mutex                                  _mutex;
+    std::condition_variable                     _cv;
+    unsigned long long                          _epoch;
+    unsigned                                    _num_parked;
+    bool                                        _stop;
+};
+
+};
+
+#endif // __LC_WORK_STEALING_POOL_HPP__
@@ -20,8 +20,11 @@ int lcmain(int argc, char* argv[])
         ("states,a", boost::program_options::value<string>()->default_value("CA,AZ,FL,GA,IL,MD,NO,NV,TX,NY"), "Comma separated list of states to test")
         ("seed,s", boost::program_options::value<unsigned>()->default_value(100), "Random Number Generator Seed")
         ("data,d", boost::program_options::value<string>()->default_value("https://www.lendingclub.com/fileDownload.action?file=LoanStatsNew.csv&type=gen"), "Download path for the notes data file")
-        ("stats,l", boost::program_options::value<string>()->default_value("LoanStatsNew.csv"), "Input Loan Stats CSV file")
+        ("stats,l", boost::program_options::value<string>()->default_value("LoanStatsNew.csv"), "Input Loan Stats CSV files, a comma separated list of paths that may use * and ? in file names")
+        ("snapshot", boost::program_options::value<string>()->default_value(""), "binary snapshot of the normalized loans reused by later runs while the size, time and first and last KiB of the stats files match, defaults to <stats>.snapshot, none disables it")
+        ("verify_load", boost::program_options::bool_switch()->default_value(false), "parse the stats files again on one thread and check the loans match the ones loaded, by the parallel parse or from the snapshot")
         ("csvresults,c", boost::program_options::value<string>()->default_value("lc_best.csv"), "Output best results CSV file")
+        ("invested", boost::program_options::value<string>()->default_value(""), "file rewritten with the rowids of the loans the best filter set matches each time a better one is found, empty for none")
         ("population_size,p", boost::program_options::value<unsigned>()->default_value(512), "population size")
         ("iterations,i", boost::program_options::value<unsigned>()->default_value(4096), "how many Genetic Algorithm iterations to perform")
         ("elite_rate,e", boost::program_options::value<double>()->default_value(0.05), "elite rate")
@@ -29,7 +32,20 @@ int lcmain(int argc, char* argv[])
         ("fitness_sort_size,f", boost::program_options::value<unsigned>()->default_value(1000), "number of loans to limit the fitness sort size, the larger the longer and more optimal solution")
         ("young_loans_in_days,y", boost::program_options::value<unsigned>()->default_value(3*30), "filter young loans if they are younger than specified number of days")
         ("workers,w", boost::program_options::value<unsigned>()->default_value(std::thread::hardware_concurrency()), "number of workers defaults to the number of cpu cores")
-        ("work_batch,b", boost::program_options::value<unsigned>()->default_value(75), "size of work batch size to give to each worker")
+        ("affinity", boost::program_options::value<string>()->default_value("compact"), "how the worker threads are pinned to cpus: none, compact (fill a cache, node and package first), scatter (spread over packages, nodes and caches) or list (--cpu_list)")
+        ("cpu_list", boost::program_options::value<string>()->default_value(""), "cpus for --affinity=list in thread order, like 0,2,8-11")
+        ("huge_pages", boost::program_options::value<string>()->default_value("hugetlb"), "pages backing the loan data and indexes: hugetlb (reserved 2 MiB pages, else transparent huge pages), madvise (transparent huge pages) or none (4 KiB pages)")
+        ("numa", boost::program_options::value<string>()->default_value("none"), "placement of the loan data the workers scan: none (one copy) or replicate (a copy on every NUMA node with workers)")
+        ("work_batch,b", boost::program_options::value<unsigned>()->default_value(75), "number of citizens a worker takes at a time with --parallel=population")
+        ("parallel", boost::program_options::value<string>()->default_value("range"), "how the workers split the work: range (each scans part of the loans for every citizen) or population (each scans all the loans for its own citizens)")
+        ("fitness_cache_size", boost::program_options::value<unsigned>()->default_value(4096), "number of filter set results to remember so unchanged citizens are not tested again, 0 disables")
+        ("batch_size", boost::program_options::value<unsigned>()->default_value(64), "number of citizens tested together in one pass over the loans, 0 tests them one at a time")
+        ("scan", boost::program_options::value<string>()->default_value("bitmap"), "how loans are matched against the filters: virtual, switch, bitmap, columnar, simd or template")
+        ("simd", boost::program_options::value<string>()->default_value("auto"), "instruction set for --scan=simd: auto, avx512, avx2, sse42 or scalar")
+        ("self_check", boost::program_options::bool_switch()->default_value(false), "check every scan against the reference scan and stop on the first difference")
+        ("filter_order", boost::program_options::value<string>()->default_value("adaptive"), "order filters are evaluated in by every scan but template: adaptive or fixed")
+        ("benchmark", boost::program_options::value<unsigned>()->default_value(0), "time every scan mode over this many random filter sets and exit")
+        ("benchmark_convert", boost::program_options::value<unsigned>()->default_value(0), "time every field converter over this many passes of the stats rows and exit")
     ;
 
     auto& args = LCArguments::Get();
@@ -83,6 +99,31 @@ int lcmain(int argc, char* argv[])
         return 1;
     }
 
+    CpuTopology::Affinity affinity;
+    if (!CpuTopology::parse_affinity(args["affinity"].as<string>(), affinity)) {
+        cout << "Unknown affinity: " << args["affinity"].as<string>() << '\n';
+        return 1;
+    }
+
+    std::vector<int> cpu_list;
+    if ((affinity == CpuTopology::Affinity::LIST) && !CpuTopology::parse_cpu_list(args["cpu_list"].as<string>(), cpu_list)) {
+        cout << "Unknown cpu list: " << args["cpu_list"].as<string>() << '\n';
+        return 1;
+    }
+
+    HugePages::Backing huge_pages;
+    if (!HugePages::parse_backing(args["huge_pages"].as<string>(), huge_pages)) {
+        cout << "Unknown huge pages backing: " << args["huge_pages"].as<string>() << '\n';
+        return 1;
+    }
+    HugePages::Get().set_backing(huge_pages);
+
+    NumaPlacement::Mode numa_mode;
+    if (!NumaPlacement::parse_mode(args["numa"].as<string>(), numa_mode)) {
+        cout << "Unknown NUMA placement: " << args["numa"].as<string>() << '\n';
+        return 1;
+    }
+
     unsigned population_size = args["population_size"].as<unsigned>();
     
     if (workers > population_size) {
@@ -128,10 +169,35 @@ int lcmain(int argc, char* argv[])
         return 1;
     }
 
+    LCBT::ParallelMode parallel_mode;
+    if (!LCBT::parse_parallel_mode(args["parallel"].as<string>(), parallel_mode)) {
+        cout << "Unknown parallel mode: " << args["parallel"].as<string>() << '\n';
+        return 1;
+    }
+
+    LCBT::ScanMode scan_mode;
+    if (!LCBT::parse_scan_mode(args["scan"].as<string>(), scan_mode)) {
+        cout << "Unknown scan mode: " << args["scan"].as<string>() << '\n';
+        return 1;
+    }
+
+    FilterKernels::Isa isa;
+    if (!FilterKernels::parse_isa(args["simd"].as<string>(), isa)) {
+        cout << "Unknown instruction set: " << args["simd"].as<string>() << '\n';
+        return 1;
+    }
+
+    string filter_order = args["filter_order"].as<string>();
+    if (filter_order != "adaptive" && filter_order != "fixed") {
+        cout << "Unknown filter order: " << filter_order << '\n';
+        return 1;
+    }
+
     srand(args["seed"].as<unsigned>());
 
     LoanTypeVector conversion_filters;
-    // The order of these must must must match the layout of the Loan stuct, as the inner core algorithm makes some assumptions
+    // The order of these must must must match the layout of the Loan stuct when using --scan=switch, as that inner core
+    // algorithm makes some assumptions. The other scan modes look up each filter's column by its type.
     //
     conversion_filters.push_back(Loan::ACC_OPEN_PAST_24MTHS);
     conversion_filters.push_back(Loan::FUNDED_AMNT);
@@ -154,6 +220,11 @@ int lcmain(int argc, char* argv[])
 
     LoanTypeVector backtest_filters = conversion_filters;
 
+    if ((scan_mode == LCBT::ScanMode::TEMPLATE) && !StandardFilterPipeline::matches(conversion_filters)) {
+        cout << "The template scan mode only supports the standard filter configuration\n";
+        return 1;
+    }
+
     LCBT* lcbt = NULL;
 
     if (workers > 1) {
@@ -164,6 +235,20 @@ int lcmain(int argc, char* argv[])
 
     lcbt->initialize();
 
+    unsigned benchmark_convert = args["benchmark_convert"].as<unsigned>();
+    if (benchmark_convert > 0) {
+        lcbt->get_loan_data().benchmark_convert(benchmark_convert);
+        lcbt->finish();
+        return 0;
+    }
+
+    unsigned benchmark = args["benchmark"].as<unsigned>();
+    if (benchmark > 0) {
+        lcbt->benchmark(benchmark);
+        lcbt->finish();
+        return 0;
+    }
+
     GATest ga_test(backtest_filters, *lcbt);
     ga_test.run();
 